@@ -0,0 +1,42 @@
+#!/bin/sh
+# Runs the benchmark scenarios headless for a fixed number of steps and writes
+# one report per scenario to <output>/<commit>/<scenario>.json, followed by a
+# CSV summary (scenario, steps, MLUPS, average SOR iterations, device memory).
+#
+# Usage: run_scenarios.sh <path/to/main> [output-dir] [steps]
+
+set -e
+
+main=${1:?"Usage: $0 <path/to/main> [output-dir] [steps]"}
+output=${2:-bench-results}
+steps=${3:-200}
+
+here=$(cd "$(dirname "$0")" && pwd)
+commit=$(git -C "$here" rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+dir="$output/$commit"
+mkdir -p "$dir"
+
+scenarios="cavity_128 cavity_256 cavity_512 cavity_1024 cavity_2048 cavity_4096 channel_obstacle porous"
+
+for s in $scenarios; do
+    echo "== $s"
+    "$main" --headless -n "$steps" \
+        -p "$here/scenarios/bench.param" \
+        -g "$here/scenarios/$s.geom" \
+        -b "$dir/$s.json" > "$dir/$s.log"
+done
+
+# summary: extract top-level values from the reports
+value() {
+    sed -n "s/^  \"$1\": \([^,]*\),\{0,1\}$/\1/p" "$2"
+}
+
+summary="$dir/summary.csv"
+echo "scenario,steps,mlups,sor_iterations_avg,device_memory" > "$summary"
+for s in $scenarios; do
+    f="$dir/$s.json"
+    echo "$s,$(value steps "$f"),$(value mlups "$f"),$(value sor_iterations_avg "$f"),$(value device_memory "$f")" >> "$summary"
+done
+
+cat "$summary"
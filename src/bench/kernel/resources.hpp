@@ -0,0 +1,14 @@
+#pragma once
+
+#include "utils/resource.hpp"
+
+
+namespace bench {
+namespace kernel {
+namespace resources {
+
+extern const utils::Resource stream_cl;
+
+}   /* namespace resources */
+}   /* namespace kernel */
+}   /* namespace bench */
@@ -0,0 +1,56 @@
+//! Kernels to measure the attainable device peak performance.
+//!
+//! The STREAM-like kernels (copy and triad) measure the attainable memory
+//! bandwidth, `peak_fma` measures the attainable single-precision arithmetic
+//! throughput using independent multiply-add chains in registers only.
+//!
+
+
+//! STREAM copy: c = a (8 bytes per element).
+__kernel void stream_copy(
+    __global const float4* a,
+    __global float4* c
+) {
+    const int i = get_global_id(0);
+    c[i] = a[i];
+}
+
+//! STREAM triad: c = a + s * b (12 bytes, 2 FLOPs per element).
+__kernel void stream_triad(
+    __global const float4* a,
+    __global const float4* b,
+    __global float4* c,
+    const float s
+) {
+    const int i = get_global_id(0);
+    c[i] = a[i] + s * b[i];
+}
+
+
+#define PEAK_FMA_ITERATIONS 256
+
+//! Multiply-add throughput: PEAK_FMA_ITERATIONS * 4 chains * 4 lanes * 2
+//! FLOPs per work-item. The result is written to keep the compiler from
+//! eliminating the computation.
+__kernel void peak_fma(
+    __global float* out,
+    const float s
+) {
+    const float x0 = (float)get_global_id(0);
+
+    float4 a = (float4)(x0, x0 + 1.0, x0 + 2.0, x0 + 3.0);
+    float4 b = a + 4.0;
+    float4 c = a + 8.0;
+    float4 d = a + 12.0;
+    const float4 t = (float4)(s);
+
+    for (int i = 0; i < PEAK_FMA_ITERATIONS; i++) {
+        a = mad(a, t, t);
+        b = mad(b, t, t);
+        c = mad(c, t, t);
+        d = mad(d, t, t);
+    }
+
+    const float4 r = a + b + c + d;
+    out[get_global_id(0)] = r.x + r.y + r.z + r.w;
+}
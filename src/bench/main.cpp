@@ -0,0 +1,677 @@
+//! Per-kernel microbenchmarks.
+//!
+//! Runs each simulation and visualization kernel in isolation on synthetic
+//! data (lid-driven cavity with random fields) for a sweep of grid sizes and
+//! reports the median kernel time (via OpenCL event profiling), the effective
+//! bandwidth and the cell throughput.
+//!
+//! Each kernel is annotated with a simple roofline model: the compulsory bytes
+//! read and written (each accessed buffer element is transferred exactly once,
+//! thus a lower bound of the actual traffic) and the floating-point operations
+//! per cell as written in the kernel source (excluding terms that only depend
+//! on kernel arguments). Achieved bandwidth and FLOP rate are reported as a
+//! fraction of the device peak, measured beforehand with STREAM-like kernels.
+//!
+//! Additionally reports the device memory of a full simulation (default
+//! parameters) per grid size: the buffers held by the simulation and the
+//! peak of the engine's buffer pool during construction and the first steps,
+//! which includes transient buffers.
+//!
+
+#include "types.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include "core/kernel/sources/resources.hpp"
+#include "core/engine.hpp"
+#include "core/geometry.hpp"
+#include "core/simulation.hpp"
+
+#include "bench/kernel/resources.hpp"
+
+#include "utils/pad.hpp"
+#include "utils/parse.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+//! Steps of the simulation whose peak memory is measured, covering all phases of a step.
+const int_t FOOTPRINT_STEPS = 3;
+
+
+struct Environment {
+    std::vector<int_t> sizes;
+    int_t reps;
+    int_t warmup;
+    char const* json;
+    char const* csv;
+};
+
+//! Single benchmark case: kernel with fixed arguments and launch configuration.
+struct Case {
+    std::string name;
+    cl::Kernel kernel;
+    cl::NDRange global;
+    cl::NDRange local;
+    std::size_t cells;              // number of processed cells per launch
+    std::size_t bytes_read;         // compulsory memory traffic per launch
+    std::size_t bytes_written;
+    double flops_per_cell;
+};
+
+//! Attainable device peak performance.
+struct Peak {
+    double gbps;
+    double gflops;
+};
+
+//! Benchmark result of a single case.
+struct Result {
+    std::string name;
+    int_t size;
+    double median_ns;
+    double gbps;
+    double gflops;
+    double intensity;               // FLOPs per byte
+    double cells_per_s;
+};
+
+//! Device memory of a simulation for a single grid size.
+struct Footprint {
+    int_t size;
+    std::size_t bytes;              // buffers held by the simulation
+    std::size_t peak;               // peak of the buffer pool, including transient buffers
+    std::size_t cells;              // including boundary cells
+};
+
+
+auto parse_cmdline(int argc, char** argv) -> Environment;
+
+auto run_case(cl::CommandQueue const& queue, Case& c, int_t reps, int_t warmup) -> double;
+
+auto measure_peak(cl::Context const& context, cl::CommandQueue const& queue, cl::Program const& program,
+                  int_t reps, int_t warmup) -> Peak;
+
+void write_json(char const* file, cl::Device const& device, Peak const& peak, std::vector<Footprint> const& memory,
+                std::vector<Result> const& results);
+void write_csv(char const* file, Peak const& peak, std::vector<Result> const& results);
+
+
+int main(int argc, char** argv) try {
+    Environment env = parse_cmdline(argc, argv);
+
+    // get first available OpenCL device, preferring GPUs
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+
+    cl::Device device;
+    for (auto const& type : {CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ALL}) {
+        for (auto const& p : platforms) {
+            std::vector<cl::Device> devices;
+            try {
+                p.getDevices(type, &devices);
+            } catch (cl::Error const&) {
+                continue;                       // no device of this type
+            }
+
+            if (!devices.empty()) {
+                device = devices.front();
+                break;
+            }
+        }
+
+        if (device()) {
+            break;
+        }
+    }
+
+    if (!device()) {
+        std::cout << "Error: No OpenCL device found\n";
+        return 1;
+    }
+
+    std::cout << "Device: " << device.getInfo<CL_DEVICE_NAME>() << "\n\n";
+
+    core::Engine engine{cl::Context{device}, device, CL_QUEUE_PROFILING_ENABLE};
+
+    auto const& context = engine.context();
+    auto const& queue = engine.queue();
+
+    auto const& prog_boundaries = engine.programs().boundaries;
+    auto const& prog_momentum = engine.programs().momentum;
+    auto const& prog_rhs = engine.programs().rhs;
+    auto const& prog_solver = engine.programs().solver;
+    auto const& prog_velocities = engine.programs().velocities;
+    auto const& prog_reduce = engine.programs().reduce;
+    auto const& prog_visualize = engine.programs().visualize;
+    auto prog_stream = core::build_program(context, device, bench::kernel::resources::stream_cl);
+
+    Peak const peak = measure_peak(context, queue, prog_stream, env.reps, env.warmup);
+
+    std::cout << "Peak bandwidth:  " << std::fixed << std::setprecision(2) << peak.gbps << " GB/s\n";
+    std::cout << "Peak arithmetic: " << peak.gflops << " GFLOP/s\n\n";
+
+    // simulation footprint: persistent buffers are acquired on construction, transient ones (geometry setup,
+    // within a step) are captured by the peak of the pool
+    std::vector<Footprint> memory;
+
+    std::cout << std::left << std::setw(28) << "simulation memory" << std::right
+              << std::setw(8) << "size" << std::setw(14) << "MiB" << std::setw(14) << "peak [MiB]"
+              << std::setw(10) << "B/cell" << "\n";
+
+    for (int_t n : env.sizes) {
+        auto footprint = Footprint{n, 0, 0, static_cast<std::size_t>(n + 2) * (n + 2)};
+
+        auto& pool = engine.pool();
+        pool.reset_peak();
+        auto const base = pool.stats().in_use;
+
+        {
+            core::Simulation sim{engine, core::Parameters{}, core::Geometry::lid_driven_cavity({n + 2, n + 2})};
+            for (int_t i = 0; i < FOOTPRINT_STEPS; i++) {
+                sim.step();
+            }
+
+            footprint.bytes = sim.device_memory();
+        }
+
+        queue.finish();
+        footprint.peak = pool.stats().peak - base;
+        pool.trim();
+
+        memory.push_back(footprint);
+
+        std::cout << std::left << std::setw(28) << "" << std::right
+                  << std::setw(8) << n
+                  << std::setw(14) << std::fixed << std::setprecision(2) << footprint.bytes / (1024.0 * 1024.0)
+                  << std::setw(14) << footprint.peak / (1024.0 * 1024.0)
+                  << std::setw(10) << std::setprecision(1)
+                  << static_cast<double>(footprint.peak) / footprint.cells << "\n";
+    }
+
+    std::cout << "\n";
+
+    std::vector<Result> results;
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<cl_float> dist{-1.0, 1.0};
+
+    std::cout << std::left << std::setw(28) << "kernel" << std::right
+              << std::setw(8) << "size" << std::setw(14) << "median [us]"
+              << std::setw(10) << "GB/s" << std::setw(8) << "%bw"
+              << std::setw(10) << "GFLOP/s" << std::setw(8) << "%flop"
+              << std::setw(8) << "F/B" << std::setw(12) << "Mcells/s" << "\n";
+
+    for (int_t n : env.sizes) {
+        auto const geom = core::Geometry::lid_driven_cavity({n + 2, n + 2});
+        auto const size = geom.size();
+
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        std::size_t const n_b = static_cast<std::size_t>(size.x) * size.y;
+        std::size_t const n_u = static_cast<std::size_t>(size.x + 1) * size.y;
+        std::size_t const n_v = static_cast<std::size_t>(size.x) * (size.y + 1);
+        std::size_t const n_rhs = static_cast<std::size_t>(size.x - 2) * (size.y - 2);
+
+        auto random_buffer = [&](std::size_t len) {
+            auto data = std::vector<cl_float>(len);
+            std::generate(data.begin(), data.end(), [&]() { return dist(rng); });
+            return cl::Buffer{context, data.begin(), data.end(), false};
+        };
+
+        auto buf_b = cl::Buffer{context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, n_b,
+                                const_cast<std::uint8_t*>(geom.data().data())};
+        auto buf_u = random_buffer(n_u);
+        auto buf_v = random_buffer(n_v);
+        auto buf_f = random_buffer(n_u);
+        auto buf_g = random_buffer(n_v);
+        auto buf_p = random_buffer(n_b);
+        auto buf_rhs = random_buffer(n_rhs);
+        auto buf_res = random_buffer(n_rhs);
+        auto buf_vis = random_buffer(n_b);
+        auto buf_prev = random_buffer(n_u);
+
+        uint_t const reduce_local_size = 128;
+        uint_t const reduce_global_size = utils::pad_up(static_cast<uint_t>(n_u), reduce_local_size);
+        auto buf_reduce_out = cl::Buffer{context, CL_MEM_WRITE_ONLY,
+                                         2 * (reduce_global_size / reduce_local_size) * sizeof(cl_float)};
+
+        auto const fl = sizeof(cl_float);
+        auto const range_b = cl::NDRange(size.x, size.y);
+        auto const range_inner = cl::NDRange(size.x - 2, size.y - 2);
+
+        // cells on the outer boundary, only these are modified by the boundary kernels of the cavity
+        std::size_t const n_perim = 2 * static_cast<std::size_t>(size.x + size.y) - 4;
+
+        std::vector<Case> cases;
+
+        // boundaries: read b, read one neighbor and write boundary cells (2 FLOPs each)
+        for (auto const& name : {"set_boundary_u", "set_boundary_v", "set_boundary_p"}) {
+            cl::Kernel kernel{prog_boundaries, name};
+            auto const is_u = std::strcmp(name, "set_boundary_u") == 0;
+            auto const is_v = std::strcmp(name, "set_boundary_v") == 0;
+
+            kernel.setArg(0, is_u ? buf_u : (is_v ? buf_v : buf_p));
+            kernel.setArg(1, buf_b);
+            kernel.setArg(2, static_cast<cl_float>(0.0));
+
+            cases.push_back({name, kernel, range_b, cl::NullRange, n_b,
+                             n_b + n_perim * fl, n_perim * fl, 2.0 * n_perim / n_b});
+        }
+
+        // momentum: read u, v, b, write f (or g), 60 FLOPs per cell (see `momentum_f_acc`)
+        for (auto const& name : {"momentum_eq_f", "momentum_eq_g"}) {
+            cl::Kernel kernel{prog_momentum, name};
+            auto const is_f = std::strcmp(name, "momentum_eq_f") == 0;
+
+            kernel.setArg(0, buf_u);
+            kernel.setArg(1, buf_v);
+            kernel.setArg(2, is_f ? buf_f : buf_g);
+            kernel.setArg(3, buf_b);
+            kernel.setArg(4, static_cast<cl_float>(0.9));
+            kernel.setArg(5, static_cast<cl_float>(1000.0));
+            kernel.setArg(6, static_cast<cl_float>(0.01));
+            kernel.setArg(7, h);
+
+            cases.push_back({name, kernel, range_b, cl::NullRange, n_b,
+                             (n_u + n_v) * fl + n_b, (is_f ? n_u : n_v) * fl, 60.0});
+        }
+
+        {   // rhs: read f, g, b, write rhs, 6 FLOPs per cell
+            cl::Kernel kernel{prog_rhs, "compute_rhs"};
+            kernel.setArg(0, buf_f);
+            kernel.setArg(1, buf_g);
+            kernel.setArg(2, buf_rhs);
+            kernel.setArg(3, buf_b);
+            kernel.setArg(4, static_cast<cl_float>(0.01));
+            kernel.setArg(5, h);
+
+            cases.push_back({"compute_rhs", kernel, range_inner, cl::NullRange, n_rhs,
+                             (n_u + n_v) * fl + n_b, n_rhs * fl, 6.0});
+        }
+
+        {   // solver
+            int_t y_cells_black = (size.y - 2) / 2;
+            auto range_red = cl::NDRange(size.x - 2, size.y - 2 - y_cells_black);
+            auto range_black = cl::NDRange(size.x - 2, y_cells_black);
+
+            // each color reads all of p (stencil) and b, but reads rhs and writes p for half of the cells only,
+            // 10 FLOPs per updated cell
+            for (auto const& name : {"cycle_red", "cycle_black"}) {
+                cl::Kernel kernel{prog_solver, name};
+                kernel.setArg(0, buf_p);
+                kernel.setArg(1, buf_rhs);
+                kernel.setArg(2, buf_b);
+                kernel.setArg(3, h);
+                kernel.setArg(4, static_cast<cl_float>(1.7));
+
+                auto const is_red = std::strcmp(name, "cycle_red") == 0;
+
+                cases.push_back({name, kernel, is_red ? range_red : range_black, cl::NullRange, n_rhs / 2,
+                                 (n_b + n_rhs / 2) * fl + n_b, (n_rhs / 2) * fl, 10.0});
+            }
+
+            // residual: read p, rhs, b, write res, 11 FLOPs per cell
+            cl::Kernel kernel{prog_solver, "residual"};
+            kernel.setArg(0, buf_p);
+            kernel.setArg(1, buf_rhs);
+            kernel.setArg(2, buf_b);
+            kernel.setArg(3, buf_res);
+            kernel.setArg(4, h);
+
+            cases.push_back({"residual", kernel, range_inner, cl::NullRange, n_rhs,
+                             (n_b + n_rhs) * fl + n_b, n_rhs * fl, 11.0});
+        }
+
+        {   // velocities: read p, f, g, b, write u, v, 8 FLOPs per cell
+            cl::Kernel kernel{prog_velocities, "new_velocities"};
+            kernel.setArg(0, buf_p);
+            kernel.setArg(1, buf_f);
+            kernel.setArg(2, buf_g);
+            kernel.setArg(3, buf_u);
+            kernel.setArg(4, buf_v);
+            kernel.setArg(5, buf_b);
+            kernel.setArg(6, static_cast<cl_float>(0.01));
+            kernel.setArg(7, h);
+
+            cases.push_back({"new_velocities", kernel, range_b, cl::NullRange, n_b,
+                             (n_b + n_u + n_v) * fl + n_b, (n_u + n_v) * fl, 8.0});
+        }
+
+        // reductions (on u): read input (and reference), per-group output is negligible
+        struct Reduction {
+            char const* name;
+            bool diff;              // takes reference input
+            bool dual;              // two values per work-item
+            double flops;
+        };
+
+        for (auto const& r : {
+            Reduction{"reduce_max_abs",      false, false, 2.0},
+            Reduction{"reduce_max",          false, false, 1.0},
+            Reduction{"reduce_min",          false, false, 1.0},
+            Reduction{"reduce_minmax",       false, true,  2.0},
+            Reduction{"reduce_sum",          false, false, 1.0},
+            Reduction{"reduce_diff_max_abs", true,  true,  5.0},
+            Reduction{"reduce_diff_sum_sq",  true,  true,  5.0},
+        }) {
+            cl::Kernel kernel{prog_reduce, r.name};
+
+            cl_uint arg = 0;
+            kernel.setArg(arg++, buf_u);
+            if (r.diff) {
+                kernel.setArg(arg++, buf_prev);
+            }
+            kernel.setArg(arg++, buf_reduce_out);
+            kernel.setArg(arg++, cl::Local((r.dual ? 2 : 1) * reduce_local_size * sizeof(cl_float)));
+            kernel.setArg(arg++, static_cast<cl_uint>(n_u));
+
+            cases.push_back({r.name, kernel, cl::NDRange(reduce_global_size), cl::NDRange(reduce_local_size), n_u,
+                             (r.diff ? 2 : 1) * n_u * fl, 0, r.flops});
+        }
+
+        // visualization: read inputs, write output
+        struct Visualization {
+            char const* name;
+            std::vector<std::pair<cl::Buffer, std::size_t>> inputs;     // buffer and size in bytes
+            bool mesh;                                                  // takes mesh width
+            double flops;
+        };
+
+        for (auto const& vis : {
+            Visualization{"visualize_boundaries",    {{buf_b, n_b}},                       false, 0.0},
+            Visualization{"visualize_p",             {{buf_p, n_b * fl}},                  false, 0.0},
+            Visualization{"visualize_rhs",           {{buf_rhs, n_rhs * fl}},              false, 0.0},
+            Visualization{"visualize_u",             {{buf_u, n_u * fl}},                  false, 0.0},
+            Visualization{"visualize_u_center",      {{buf_u, n_u * fl}},                  false, 2.0},
+            Visualization{"visualize_v",             {{buf_v, n_v * fl}},                  false, 0.0},
+            Visualization{"visualize_v_center",      {{buf_v, n_v * fl}},                  false, 2.0},
+            Visualization{"visualize_uv_abs",        {{buf_u, n_u * fl}, {buf_v, n_v * fl}}, false, 4.0},
+            Visualization{"visualize_uv_abs_center", {{buf_u, n_u * fl}, {buf_v, n_v * fl}}, false, 8.0},
+            Visualization{"visualize_vorticity",     {{buf_u, n_u * fl}, {buf_v, n_v * fl}}, true,  5.0},
+
+            // line integral from the bottom boundary, on average (size.x + size.y) / 2 terms of 2 FLOPs
+            Visualization{"visualize_stream",        {{buf_u, n_u * fl}, {buf_v, n_v * fl}}, true,
+                          static_cast<double>(size.x + size.y)},
+        }) {
+            cl::Kernel kernel{prog_visualize, vis.name};
+            kernel.setArg(0, buf_vis);
+
+            cl_uint arg = 1;
+            std::size_t bytes_read = 0;
+            for (auto const& input : vis.inputs) {
+                kernel.setArg(arg++, input.first);
+                bytes_read += input.second;
+            }
+
+            if (vis.mesh) {
+                kernel.setArg(arg++, h);
+            }
+
+            cases.push_back({vis.name, kernel, range_b, cl::NullRange, n_b, bytes_read, n_b * fl, vis.flops});
+        }
+
+        for (auto& c : cases) {
+            double const ns = run_case(queue, c, env.reps, env.warmup);
+            double const bytes = static_cast<double>(c.bytes_read + c.bytes_written);
+            double const flops = c.flops_per_cell * c.cells;
+
+            auto result = Result{c.name, n, ns, bytes / ns, flops / ns, flops / bytes, c.cells / (ns * 1e-9)};
+            results.push_back(result);
+
+            std::cout << std::left << std::setw(28) << result.name << std::right
+                      << std::setw(8) << n
+                      << std::setw(14) << std::fixed << std::setprecision(2) << ns * 1e-3
+                      << std::setw(10) << result.gbps
+                      << std::setw(8) << std::setprecision(1) << 100.0 * result.gbps / peak.gbps
+                      << std::setw(10) << std::setprecision(2) << result.gflops
+                      << std::setw(8) << std::setprecision(1) << 100.0 * result.gflops / peak.gflops
+                      << std::setw(8) << std::setprecision(2) << result.intensity
+                      << std::setw(12) << result.cells_per_s * 1e-6 << "\n";
+        }
+    }
+
+    if (env.json) {
+        write_json(env.json, device, peak, memory, results);
+    }
+
+    if (env.csv) {
+        write_csv(env.csv, peak, results);
+    }
+
+} catch (cl::BuildError const& err) {
+    auto const& log = err.getBuildLog();
+    std::cerr << "OpenCL Build Error: " << err.what() << "\n";
+    for (auto const& entry : log) {
+        std::cerr << "-- LOG -------------------------------------------------------------------------\n";
+        std::cout << "-- Device: " << entry.first.getInfo<CL_DEVICE_NAME>() << "\n";
+        std::cout << entry.second << "\n";
+    }
+    std::cerr << "--------------------------------------------------------------------------------\n";
+    throw err;
+
+} catch (cl::Error const& err) {
+    std::cerr << "OpenCL Error:\n";
+    std::cerr << "  What: " << err.what() << "\n";
+    std::cerr << "  Code: " << err.err() << "\n";
+    throw err;
+}
+
+
+auto run_case(cl::CommandQueue const& queue, Case& c, int_t reps, int_t warmup) -> double {
+    for (int_t i = 0; i < warmup; i++) {
+        queue.enqueueNDRangeKernel(c.kernel, cl::NullRange, c.global, c.local);
+    }
+    queue.finish();
+
+    std::vector<double> times;
+    for (int_t i = 0; i < reps; i++) {
+        cl::Event event;
+        queue.enqueueNDRangeKernel(c.kernel, cl::NullRange, c.global, c.local, nullptr, &event);
+        event.wait();
+
+        auto const start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        auto const end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        times.push_back(static_cast<double>(end - start));
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+auto measure_peak(cl::Context const& context, cl::CommandQueue const& queue, cl::Program const& program,
+                  int_t reps, int_t warmup) -> Peak
+{
+    auto const device = queue.getInfo<CL_QUEUE_DEVICE>();
+
+    // STREAM arrays: 64 MiB each (well beyond any cache), limited by the maximum allocation size
+    std::size_t const max_alloc = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    std::size_t const n = std::min<std::size_t>(std::size_t{1} << 22, max_alloc / sizeof(cl_float4));
+    std::size_t const bytes = n * sizeof(cl_float4);
+
+    auto buf_a = cl::Buffer{context, CL_MEM_READ_WRITE, bytes};
+    auto buf_b = cl::Buffer{context, CL_MEM_READ_WRITE, bytes};
+    auto buf_c = cl::Buffer{context, CL_MEM_READ_WRITE, bytes};
+
+    queue.enqueueFillBuffer(buf_a, cl_float{1.0}, 0, bytes);
+    queue.enqueueFillBuffer(buf_b, cl_float{2.0}, 0, bytes);
+
+    cl::Kernel kernel_copy{program, "stream_copy"};
+    kernel_copy.setArg(0, buf_a);
+    kernel_copy.setArg(1, buf_c);
+
+    cl::Kernel kernel_triad{program, "stream_triad"};
+    kernel_triad.setArg(0, buf_a);
+    kernel_triad.setArg(1, buf_b);
+    kernel_triad.setArg(2, buf_c);
+    kernel_triad.setArg(3, static_cast<cl_float>(3.0));
+
+    auto copy = Case{"stream_copy", kernel_copy, cl::NDRange(n), cl::NullRange, n, bytes, bytes, 0.0};
+    auto triad = Case{"stream_triad", kernel_triad, cl::NDRange(n), cl::NullRange, n, 2 * bytes, bytes, 0.0};
+
+    double const ns_copy = run_case(queue, copy, reps, warmup);
+    double const ns_triad = run_case(queue, triad, reps, warmup);
+
+    double const gbps = std::max(2.0 * bytes / ns_copy, 3.0 * bytes / ns_triad);
+
+    // arithmetic peak: enough work-items to fill the device (see `peak_fma` for FLOPs per work-item)
+    std::size_t const fma_items = 1 << 20;
+    double const fma_flops_per_item = 256.0 * 4.0 * 4.0 * 2.0;
+
+    auto buf_out = cl::Buffer{context, CL_MEM_WRITE_ONLY, fma_items * sizeof(cl_float)};
+
+    cl::Kernel kernel_fma{program, "peak_fma"};
+    kernel_fma.setArg(0, buf_out);
+    kernel_fma.setArg(1, static_cast<cl_float>(0.999));
+
+    auto fma = Case{"peak_fma", kernel_fma, cl::NDRange(fma_items), cl::NullRange, fma_items,
+                    0, fma_items * sizeof(cl_float), fma_flops_per_item};
+
+    double const ns_fma = run_case(queue, fma, reps, warmup);
+    double const gflops = fma_flops_per_item * fma_items / ns_fma;
+
+    return {gbps, gflops};
+}
+
+void write_json(char const* file, cl::Device const& device, Peak const& peak, std::vector<Footprint> const& memory,
+                std::vector<Result> const& results)
+{
+    std::ofstream out{file};
+
+    out << "{\n";
+    out << "  \"device\": \"" << device.getInfo<CL_DEVICE_NAME>() << "\",\n";
+    out << "  \"peak\": {\"gbps\": " << peak.gbps << ", \"gflops\": " << peak.gflops << "},\n";
+    out << "  \"memory\": [\n";
+
+    for (std::size_t i = 0; i < memory.size(); i++) {
+        out << "    {\"size\": " << memory[i].size << ", \"bytes\": " << memory[i].bytes
+            << ", \"peak\": " << memory[i].peak << ", \"cells\": " << memory[i].cells << "}"
+            << (i + 1 < memory.size() ? ",\n" : "\n");
+    }
+
+    out << "  ],\n";
+    out << "  \"results\": [\n";
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        auto const& r = results[i];
+
+        out << "    {\"kernel\": \"" << r.name << "\", \"size\": " << r.size
+            << ", \"median_ns\": " << r.median_ns
+            << ", \"gbps\": " << r.gbps << ", \"bw_fraction\": " << r.gbps / peak.gbps
+            << ", \"gflops\": " << r.gflops << ", \"flops_fraction\": " << r.gflops / peak.gflops
+            << ", \"intensity\": " << r.intensity
+            << ", \"cells_per_s\": " << r.cells_per_s << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n";
+    out << "}\n";
+}
+
+void write_csv(char const* file, Peak const& peak, std::vector<Result> const& results) {
+    std::ofstream out{file};
+
+    out << "kernel,size,median_ns,gbps,bw_fraction,gflops,flops_fraction,intensity,cells_per_s\n";
+    for (auto const& r : results) {
+        out << r.name << "," << r.size << "," << r.median_ns << ","
+            << r.gbps << "," << r.gbps / peak.gbps << ","
+            << r.gflops << "," << r.gflops / peak.gflops << ","
+            << r.intensity << "," << r.cells_per_s << "\n";
+    }
+}
+
+
+auto parse_cmdline(int argc, char** argv) -> Environment {
+    auto print_usage_and_exit = [&](int status, std::string msg = "") {
+        if (!msg.empty()) std::cout << msg << "\n\n";
+        std::cout <<
+            "Usage:\n"
+            "  " << argv[0] << " [options]\n"
+            "\n"
+            "Options:\n"
+            "  -h --help                 Show this help message\n"
+            "  -s --sizes <n,n,...>      Interior grid sizes (default: 128,256,512,1024,2048)\n"
+            "  -r --reps <n>             Timed repetitions per kernel (default: 20)\n"
+            "  -w --warmup <n>           Warm-up repetitions per kernel (default: 3)\n"
+            "  --json <file>             Write results as JSON\n"
+            "  --csv <file>              Write results as CSV\n";
+        std::cout << std::endl;
+        std::exit(status);
+    };
+
+    Environment env{{128, 256, 512, 1024, 2048}, 20, 3, nullptr, nullptr};
+    for (int i = 1; i < argc; i++) {
+        char* arg = argv[i];
+
+        auto next = [&](char const* name) -> char* {
+            if (++i >= argc) {
+                std::stringstream msg;
+                msg << "Error: Missing argument for '" << name << "'.";
+                print_usage_and_exit(1, msg.str());
+            }
+            return argv[i];
+        };
+
+        // the whole value has to be a valid integer
+        auto number = [&](std::string const& value, char const* name) -> int {
+            long long result = 0;
+            if (!utils::parse_int(value, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), result)) {
+                std::stringstream msg;
+                msg << "Error: Invalid value '" << value << "' for '" << name << "'.";
+                print_usage_and_exit(1, msg.str());
+            }
+            return static_cast<int>(result);
+        };
+
+        if (std::strcmp("-h", arg) == 0 || std::strcmp("--help", arg) == 0) {
+            print_usage_and_exit(0);
+
+        } else if (std::strcmp("-s", arg) == 0 || std::strcmp("--sizes", arg) == 0) {
+            std::stringstream list{next("--sizes")};
+            std::string item;
+
+            env.sizes.clear();
+            while (std::getline(list, item, ',')) {
+                int const size = number(item, "--sizes");
+                if (size <= 0) {
+                    std::stringstream msg;
+                    msg << "Error: Grid sizes must be positive, got '" << item << "'.";
+                    print_usage_and_exit(1, msg.str());
+                }
+                env.sizes.push_back(size);
+            }
+
+            if (env.sizes.empty()) {
+                print_usage_and_exit(1, "Error: No grid sizes given for '--sizes'.");
+            }
+
+        } else if (std::strcmp("-r", arg) == 0 || std::strcmp("--reps", arg) == 0) {
+            env.reps = std::max(number(next("--reps"), "--reps"), 1);
+
+        } else if (std::strcmp("-w", arg) == 0 || std::strcmp("--warmup", arg) == 0) {
+            env.warmup = std::max(number(next("--warmup"), "--warmup"), 0);
+
+        } else if (std::strcmp("--json", arg) == 0) {
+            env.json = next("--json");
+
+        } else if (std::strcmp("--csv", arg) == 0) {
+            env.csv = next("--csv");
+
+        } else {
+            std::stringstream msg;
+            msg << "Error: Unknown argument '" << arg << "'.";
+            print_usage_and_exit(1, msg.str());
+        }
+    }
+
+    return env;
+}
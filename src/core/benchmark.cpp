@@ -0,0 +1,115 @@
+#include "core/benchmark.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+// for the estimate of the memory traffic from last-level cache misses
+const std::uint64_t CACHE_LINE_SIZE = 64;
+
+auto quote(std::string const& str) -> std::string {
+    std::string out = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+}   /* namespace */
+
+
+auto BenchmarkReport::solver_time() const -> double {
+    return phase_time[static_cast<std::size_t>(Phase::Dt)]
+         + phase_time[static_cast<std::size_t>(Phase::Momentum)]
+         + phase_time[static_cast<std::size_t>(Phase::Pressure)]
+         + phase_time[static_cast<std::size_t>(Phase::Velocity)];
+}
+
+auto BenchmarkReport::mlups() const -> double {
+    double const time = solver_time();
+    if (time <= 0.0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(fluid_cells) * steps.size() / time * 1e-6;
+}
+
+void BenchmarkReport::save(char const* file) const {
+    std::ofstream out{file};
+    if (!out) {
+        std::stringstream msg;
+        msg << "Failed to open benchmark output `" << file << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    uint_t const n = steps.size();
+    // long runs overflow 32 bits, see `Simulation::sor_iterations_total()`
+    std::uint64_t const sor_total = std::accumulate(steps.begin(), steps.end(), std::uint64_t{0},
+        [](std::uint64_t acc, StepSample const& s) { return acc + s.sor_iterations; });
+
+    out << std::setprecision(9);
+    out << "{\n";
+    out << "  \"device\": " << quote(device) << ",\n";
+    out << "  \"scenario\": " << quote(scenario) << ",\n";
+    out << "  \"size\": [" << size.x << ", " << size.y << "],\n";
+    out << "  \"fluid_cells\": " << fluid_cells << ",\n";
+    out << "  \"device_memory\": " << device_memory << ",\n";
+    out << "  \"steps\": " << n << ",\n";
+    out << "  \"frames\": " << frames << ",\n";
+    out << "  \"wall_time\": " << wall_time << ",\n";
+    out << "  \"solver_time\": " << solver_time() << ",\n";
+    out << "  \"mlups\": " << mlups() << ",\n";
+    out << "  \"sor_iterations_avg\": " << (n > 0 ? static_cast<double>(sor_total) / n : 0.0) << ",\n";
+
+    out << "  \"phases\": {\n";
+    for (std::size_t i = 0; i < NUM_PHASES; i++) {
+        out << "    " << quote(phase_to_string(static_cast<Phase>(i))) << ": {"
+            << "\"total\": " << phase_time[i] << ", "
+            << "\"per_step\": " << (n > 0 ? phase_time[i] / n : 0.0);
+
+        // hardware counters, memory bandwidth is estimated from LLC misses (one cache line each)
+        if (has_counters) {
+            auto const& c = phase_counters[i];
+            auto const cycles = c[PerfEvent::Cycles];
+            auto const instructions = c[PerfEvent::Instructions];
+            auto const llc_misses = c[PerfEvent::LlcMisses];
+
+            double const ipc = cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+            double const bytes = static_cast<double>(llc_misses * CACHE_LINE_SIZE);
+            double const bandwidth = phase_time[i] > 0.0 ? bytes / phase_time[i] * 1e-9 : 0.0;
+
+            out << ", \"counters\": {"
+                << "\"cycles\": " << cycles << ", "
+                << "\"instructions\": " << instructions << ", "
+                << "\"llc_misses\": " << llc_misses << ", "
+                << "\"ipc\": " << ipc << ", "
+                << "\"llc_miss_bytes\": " << bytes << ", "
+                << "\"bandwidth_gbps\": " << bandwidth << "}";
+        }
+
+        out << "}" << (i + 1 < NUM_PHASES ? ",\n" : "\n");
+    }
+    out << "  },\n";
+
+    // per-step records as [t, dt, sor_iterations, residual, time]
+    out << "  \"step_samples\": [\n";
+    for (uint_t i = 0; i < n; i++) {
+        auto const& s = steps[i];
+        out << "    [" << s.t << ", " << s.dt << ", " << s.sor_iterations << ", " << s.residual << ", " << s.time << "]"
+            << (i + 1 < n ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}   /* namespace core */
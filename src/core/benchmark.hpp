@@ -0,0 +1,52 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/timing.hpp"
+#include "core/perf_counters.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+
+namespace core {
+
+//! Record of a single time step.
+struct StepSample {
+    real_t t;
+    real_t dt;
+    uint_t sor_iterations;
+    real_t residual;
+    double time;                    //!< wall-clock time of the step in seconds
+};
+
+//! Results of a benchmark run.
+//!
+//! The throughput is given in million (fluid) cell updates per second (MLUPS)
+//! and is based on the time spent in the solver phases only, i.e. excluding
+//! visualization and setup.
+struct BenchmarkReport {
+    std::string device;
+    std::string scenario;
+
+    ivec2 size;
+    uint_t fluid_cells;
+    std::size_t device_memory;      //!< allocated device buffers in bytes
+
+    uint_t frames;
+    double wall_time;               //!< wall-clock time of the main loop in seconds
+    std::array<double, NUM_PHASES> phase_time;
+
+    bool has_counters;              //!< whether hardware counters have been captured
+    std::array<PerfSample, NUM_PHASES> phase_counters;
+
+    std::vector<StepSample> steps;
+
+    auto solver_time() const -> double;
+    auto mlups() const -> double;
+
+    //! Write report as JSON.
+    void save(char const* file) const;
+};
+
+}   /* namespace core */
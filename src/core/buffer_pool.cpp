@@ -0,0 +1,116 @@
+#include "core/buffer_pool.hpp"
+
+#include <algorithm>
+
+
+namespace core {
+namespace {
+
+//! Smallest size class in bytes.
+const std::size_t MIN_SIZE_CLASS = 256;
+
+}   /* namespace */
+
+
+BufferPool::BufferPool(cl::Context const& context, std::size_t max_free)
+    : m_context{context}
+    , m_max_free{max_free}
+    , m_mutex{}
+    , m_free{}
+    , m_stats{0, 0, 0, 0, 0, 0} {}
+
+auto BufferPool::acquire(std::size_t size, cl_mem_flags flags) -> cl::Buffer {
+    auto const key = Key{flags, size_class(size)};
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    cl::Buffer buffer;
+
+    // most recently released buffer of the class
+    auto it = std::find_if(m_free.rbegin(), m_free.rend(), [&](std::pair<Key, cl::Buffer> const& entry) {
+        return entry.first == key;
+    });
+
+    if (it != m_free.rend()) {
+        buffer = std::move(it->second);
+        m_free.erase(std::next(it).base());
+
+        m_stats.reused += 1;
+
+    } else {
+        try {
+            buffer = cl::Buffer{m_context, flags, key.second};
+        } catch (cl::Error const& err) {
+            if (err.err() != CL_MEM_OBJECT_ALLOCATION_FAILURE && err.err() != CL_OUT_OF_RESOURCES) {
+                throw;
+            }
+
+            // free buffers of other classes may be in the way
+            evict(0);
+            buffer = cl::Buffer{m_context, flags, key.second};
+        }
+
+        m_stats.allocated += key.second;
+        m_stats.created += 1;
+    }
+
+    m_stats.in_use += key.second;
+    m_stats.peak = std::max(m_stats.peak, m_stats.in_use);
+
+    return buffer;
+}
+
+void BufferPool::release(cl::Buffer const& buffer) {
+    if (!buffer()) {
+        return;
+    }
+
+    auto const key = Key{buffer.getInfo<CL_MEM_FLAGS>(), buffer.getInfo<CL_MEM_SIZE>()};
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_free.emplace_back(key, buffer);
+    m_stats.in_use -= key.second;
+
+    evict(m_max_free);
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    evict(0);
+}
+
+auto BufferPool::stats() const -> BufferPoolStats {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_stats;
+}
+
+void BufferPool::reset_peak() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stats.peak = m_stats.in_use;
+}
+
+auto BufferPool::size_class(std::size_t size) -> std::size_t {
+    if (size <= MIN_SIZE_CLASS) {
+        return MIN_SIZE_CLASS;
+    }
+
+    // largest power of two not above size, classes are spaced by an eighth of it
+    std::size_t base = MIN_SIZE_CLASS;
+    while (base <= size / 2) {
+        base *= 2;
+    }
+
+    std::size_t const step = base / 8;
+    return (size + step - 1) / step * step;
+}
+
+void BufferPool::evict(std::size_t max_free) {
+    // requires the lock to be held
+    while (!m_free.empty() && m_stats.allocated - m_stats.in_use > max_free) {
+        m_stats.allocated -= m_free.front().first.second;
+        m_stats.evicted += 1;
+        m_free.pop_front();
+    }
+}
+
+}   /* namespace core */
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "opencl/opencl.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <utility>
+
+
+namespace core {
+
+//! Memory accounting of a `BufferPool` in bytes.
+struct BufferPoolStats {
+    std::size_t allocated;          //!< all buffers created by the pool (in use and free)
+    std::size_t in_use;             //!< buffers currently acquired
+    std::size_t peak;               //!< maximum of `in_use`
+    std::uint64_t created;          //!< number of buffers created
+    std::uint64_t reused;           //!< number of acquisitions served from the pool
+    std::uint64_t evicted;          //!< number of free buffers destroyed (limit, allocation failures, trim)
+};
+
+
+//! Pool of device buffers, reused across simulations instead of creating
+//! new buffers for each run.
+//!
+//! Requested sizes are rounded up to size classes (eight per power of two,
+//! i.e. at most 12.5% overhead), buffers are reused for requests of the same
+//! class and memory flags. Released buffers are kept up to `max_free` bytes,
+//! beyond that the least recently released ones are destroyed. All free
+//! buffers are destroyed if the device fails to allocate a new buffer (and
+//! the allocation is retried) or via `trim()`.
+//!
+//! Buffers may be released while commands using them are still pending, as
+//! long as all users of the pool enqueue to the same in-order queue.
+class BufferPool {
+public:
+    BufferPool(cl::Context const& context, std::size_t max_free);
+    BufferPool(BufferPool const&) = delete;
+
+    auto operator= (BufferPool const&) -> BufferPool& = delete;
+
+    //! Returns a buffer of at least the given size.
+    auto acquire(std::size_t size, cl_mem_flags flags = CL_MEM_READ_WRITE) -> cl::Buffer;
+
+    //! Returns the buffer to the pool. Null buffers are ignored.
+    void release(cl::Buffer const& buffer);
+
+    //! Destroys all free buffers.
+    void trim();
+
+    auto stats() const -> BufferPoolStats;
+
+    //! Restarts the peak at the memory currently in use, e.g. to measure the
+    //! peak of a single simulation.
+    void reset_peak();
+
+    //! Size class of the given size in bytes.
+    static auto size_class(std::size_t size) -> std::size_t;
+
+private:
+    using Key = std::pair<cl_mem_flags, std::size_t>;
+
+    void evict(std::size_t max_free);
+
+    cl::Context m_context;
+    std::size_t m_max_free;
+
+    mutable std::mutex m_mutex;
+    std::list<std::pair<Key, cl::Buffer>> m_free;       // least recently released first
+    BufferPoolStats m_stats;
+};
+
+}   /* namespace core */
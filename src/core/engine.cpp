@@ -0,0 +1,68 @@
+#include "core/engine.hpp"
+
+#include "core/kernel/sources/resources.hpp"
+
+
+namespace core {
+namespace {
+
+const char* OCL_COMPILER_OPTIONS =
+    "-cl-single-precision-constant "
+    "-cl-denorms-are-zero "
+    "-cl-strict-aliasing "
+    "-cl-fast-relaxed-math "
+    "-Werror";
+
+//! Free pool buffers are retained up to this fraction of the device memory.
+const std::size_t POOL_MAX_FREE_DIVISOR = 4;
+
+}   /* namespace */
+
+
+auto build_program(cl::Context const& context, cl::Device const& device, utils::Resource const& source)
+    -> cl::Program
+{
+    cl::Program::Sources sources;
+    sources.push_back(source.to_string());
+
+    cl::Program program{context, sources};
+    program.build({device}, OCL_COMPILER_OPTIONS);
+
+    return program;
+}
+
+
+auto Programs::build(cl::Context const& context, cl::Device const& device) -> Programs {
+    namespace res = core::kernel::resources;
+
+    Programs programs;
+    programs.zero = build_program(context, device, res::zero_cl);
+    programs.arith = build_program(context, device, res::arith_cl);
+    programs.statistics = build_program(context, device, res::statistics_cl);
+    programs.probes = build_program(context, device, res::probes_cl);
+    programs.forces = build_program(context, device, res::forces_cl);
+    programs.visualize = build_program(context, device, res::visualize_cl);
+    programs.boundaries = build_program(context, device, res::boundaries_cl);
+    programs.momentum = build_program(context, device, res::momentum_cl);
+    programs.diffusion = build_program(context, device, res::diffusion_cl);
+    programs.rhs = build_program(context, device, res::rhs_cl);
+    programs.solver = build_program(context, device, res::solver_cl);
+    programs.velocities = build_program(context, device, res::velocities_cl);
+    programs.reduce = build_program(context, device, res::reduce_cl);
+    programs.copy = build_program(context, device, res::copy_cl);
+    programs.geometry = build_program(context, device, res::geometry_cl);
+
+    return programs;
+}
+
+
+Engine::Engine(cl::Context const& context, cl::Device const& device, cl_command_queue_properties queue_properties,
+               char const* trace)
+    : m_context{context}
+    , m_device{device}
+    , m_queue{context, device, queue_properties}
+    , m_programs{Programs::build(context, device)}
+    , m_pool{context, device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / POOL_MAX_FREE_DIVISOR}
+    , m_tracer{m_queue, trace} {}
+
+}   /* namespace core */
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/trace.hpp"
+#include "core/buffer_pool.hpp"
+
+#include "utils/resource.hpp"
+
+#include "opencl/opencl.hpp"
+
+
+namespace core {
+
+//! Builds the program from the given source with the compiler options of the
+//! solver, e.g. for additional kernels operating on simulation buffers.
+auto build_program(cl::Context const& context, cl::Device const& device, utils::Resource const& source)
+    -> cl::Program;
+
+
+//! Compiled solver programs.
+struct Programs {
+    cl::Program zero;
+    cl::Program arith;
+    cl::Program statistics;
+    cl::Program probes;
+    cl::Program forces;
+    cl::Program visualize;
+    cl::Program boundaries;
+    cl::Program momentum;
+    cl::Program diffusion;
+    cl::Program rhs;
+    cl::Program solver;
+    cl::Program velocities;
+    cl::Program reduce;
+    cl::Program copy;
+    cl::Program geometry;
+
+    //! Builds all programs for the given device.
+    static auto build(cl::Context const& context, cl::Device const& device) -> Programs;
+};
+
+
+//! OpenCL context, command queue, compiled programs and buffer pool, shared
+//! by any number of (consecutive) simulations to avoid the setup cost per
+//! run.
+//!
+//! All kernels are enqueued via the tracer, which records them if a trace
+//! file is given (requires `CL_QUEUE_PROFILING_ENABLE`). Buffer copies,
+//! fills and transfers are enqueued directly and are not recorded.
+class Engine {
+public:
+    Engine(cl::Context const& context, cl::Device const& device, cl_command_queue_properties queue_properties = 0,
+           char const* trace = nullptr);
+    Engine(Engine const&) = delete;
+
+    inline auto context() const -> cl::Context const&;
+    inline auto device() const -> cl::Device const&;
+    inline auto queue() const -> cl::CommandQueue const&;
+    inline auto programs() const -> Programs const&;
+    inline auto pool() -> BufferPool&;
+    inline auto tracer() -> Tracer&;
+
+    //! Enqueues the kernel via the tracer.
+    inline void enqueue(cl::Kernel const& kernel, cl::NDRange const& global, cl::NDRange const& local);
+
+private:
+    cl::Context m_context;
+    cl::Device m_device;
+    cl::CommandQueue m_queue;
+    Programs m_programs;
+    BufferPool m_pool;
+    Tracer m_tracer;
+};
+
+
+auto Engine::context() const -> cl::Context const& {
+    return m_context;
+}
+
+auto Engine::device() const -> cl::Device const& {
+    return m_device;
+}
+
+auto Engine::queue() const -> cl::CommandQueue const& {
+    return m_queue;
+}
+
+auto Engine::programs() const -> Programs const& {
+    return m_programs;
+}
+
+auto Engine::pool() -> BufferPool& {
+    return m_pool;
+}
+
+auto Engine::tracer() -> Tracer& {
+    return m_tracer;
+}
+
+void Engine::enqueue(cl::Kernel const& kernel, cl::NDRange const& global, cl::NDRange const& local) {
+    m_tracer.enqueue(m_queue, kernel, global, local);
+}
+
+}   /* namespace core */
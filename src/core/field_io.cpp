@@ -0,0 +1,141 @@
+#include "core/field_io.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <sstream>
+
+
+namespace core {
+namespace {
+
+const char FIELD_MAGIC[8] = {'N', 'S', 'F', 'I', 'E', 'L', 'D', '1'};
+const std::size_t FIELD_NAME_LEN = 32;
+
+template <typename T>
+inline void write_value(std::ofstream& out, T const& value) {
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline auto read_value(std::ifstream& in) -> T {
+    T value;
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+[[noreturn]] void fail(char const* what, char const* file) {
+    std::stringstream msg;
+    msg << what << " `" << file << "`";
+    throw std::runtime_error(msg.str());
+}
+
+//! Unique name of a temporary file next to `file`, concurrent writers of the
+//! same file (threads or processes) never share their temporary files.
+auto temporary_name(char const* file) -> std::string {
+    std::random_device random;
+
+    std::stringstream name;
+    name << file << ".tmp." << std::hex << std::setfill('0')
+         << std::setw(8) << random() << std::setw(8) << random();
+
+    return name.str();
+}
+
+}   /* namespace */
+
+
+void FieldSet::save(char const* file) const {
+    for (auto const& field : fields) {
+        if (field.data.size() != static_cast<std::size_t>(field.size.x) * field.size.y) {
+            throw std::invalid_argument{"Field size does not match field data"};
+        }
+    }
+
+    // write to temporary file first, readers never see partial files
+    auto const tmp = temporary_name(file);
+
+    {
+        std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+        if (!out) {
+            fail("Failed to open field file", tmp.c_str());
+        }
+
+        out.write(FIELD_MAGIC, sizeof(FIELD_MAGIC));
+        write_value<std::uint32_t>(out, size.x);
+        write_value<std::uint32_t>(out, size.y);
+        write_value<float>(out, length.x);
+        write_value<float>(out, length.y);
+        write_value<float>(out, time);
+        write_value<std::uint32_t>(out, fields.size());
+
+        for (auto const& field : fields) {
+            char name[FIELD_NAME_LEN] = {};
+            std::strncpy(name, field.name.c_str(), FIELD_NAME_LEN - 1);
+
+            out.write(name, FIELD_NAME_LEN);
+            write_value<std::uint32_t>(out, field.size.x);
+            write_value<std::uint32_t>(out, field.size.y);
+            out.write(reinterpret_cast<char const*>(field.data.data()), field.data.size() * sizeof(float));
+        }
+
+        out.close();
+
+        if (!out) {
+            std::remove(tmp.c_str());
+            fail("Failed to write field file", tmp.c_str());
+        }
+    }
+
+    if (std::rename(tmp.c_str(), file) != 0) {
+        std::remove(tmp.c_str());
+        fail("Failed to replace field file", file);
+    }
+}
+
+auto FieldSet::load(char const* file) -> FieldSet {
+    std::ifstream in{file, std::ios::binary};
+    if (!in) {
+        fail("Failed to open field file", file);
+    }
+
+    char magic[sizeof(FIELD_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, FIELD_MAGIC, sizeof(FIELD_MAGIC)) != 0) {
+        fail("Invalid field file", file);
+    }
+
+    FieldSet set;
+    set.size.x = read_value<std::uint32_t>(in);
+    set.size.y = read_value<std::uint32_t>(in);
+    set.length.x = read_value<float>(in);
+    set.length.y = read_value<float>(in);
+    set.time = read_value<float>(in);
+
+    auto const n_fields = read_value<std::uint32_t>(in);
+    for (std::uint32_t i = 0; i < n_fields && in; i++) {
+        char name[FIELD_NAME_LEN];
+        in.read(name, FIELD_NAME_LEN);
+        name[FIELD_NAME_LEN - 1] = '\0';
+
+        Field field;
+        field.name = name;
+        field.size.x = read_value<std::uint32_t>(in);
+        field.size.y = read_value<std::uint32_t>(in);
+        field.data.resize(static_cast<std::size_t>(field.size.x) * field.size.y);
+        in.read(reinterpret_cast<char*>(field.data.data()), field.data.size() * sizeof(float));
+
+        set.fields.push_back(std::move(field));
+    }
+
+    if (!in) {
+        fail("Truncated field file", file);
+    }
+
+    return set;
+}
+
+}   /* namespace core */
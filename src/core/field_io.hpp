@@ -0,0 +1,58 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+#include <vector>
+
+
+namespace core {
+
+//! Single named field on a two-dimensional grid.
+struct Field {
+    std::string name;
+    uvec2 size;
+    std::vector<float> data;
+};
+
+//! Collection of fields of a simulation state, stored in a simple binary
+//! format (little endian):
+//!
+//!   char[8]       magic "NSFIELD1"
+//!   uint32[2]     grid size (cells, including boundary)
+//!   float32[2]    grid length
+//!   float32       simulation time
+//!   uint32        number of fields
+//!
+//!   per field:
+//!     char[32]      name, zero padded
+//!     uint32[2]     field size
+//!     float32[...]  data, row-major
+//!
+struct FieldSet {
+    ivec2 size;
+    rvec2 length;
+    real_t time;
+    std::vector<Field> fields;
+
+    inline auto find(std::string const& name) const -> Field const*;
+
+    //! Write fields to file. The file is replaced atomically.
+    void save(char const* file) const;
+
+    //! Load fields from file.
+    static auto load(char const* file) -> FieldSet;
+};
+
+
+auto FieldSet::find(std::string const& name) const -> Field const* {
+    for (auto const& field : fields) {
+        if (field.name == name) {
+            return &field;
+        }
+    }
+
+    return nullptr;
+}
+
+}   /* namespace core */
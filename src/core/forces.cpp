@@ -0,0 +1,101 @@
+#include "core/forces.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+//! Work-group size of the force integration (single work-group).
+const uint_t FORCES_LOCAL_SIZE = 128;
+
+}   /* namespace */
+
+
+ForceRecorder::ForceRecorder(cl::Context const& context, cl::Program const& program, std::string const& output,
+                             real_t u_ref, real_t l_ref, ivec2 size, uint_t capacity)
+    : m_size{size}
+    , m_coeff_scale{static_cast<real_t>(2.0) / (u_ref * u_ref * l_ref)}
+    , m_out{output, std::ios::trunc}
+    , m_kernel_compact{program, "compact_interfaces"}
+    , m_kernel_integrate{program, "integrate_forces"}
+    , m_num_interfaces{0}
+    , m_capacity{std::max<uint_t>(capacity, 1)}
+{
+    if (!m_out) {
+        std::stringstream msg;
+        msg << "Failed to open force output `" << output << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    auto const n_cells = static_cast<std::size_t>(size.x) * size.y;
+    m_list = cl::Buffer{context, CL_MEM_READ_WRITE, n_cells * sizeof(cl_uint)};
+    m_count = cl::Buffer{context, CL_MEM_READ_WRITE, sizeof(cl_uint)};
+    m_series = cl::Buffer{context, CL_MEM_READ_WRITE, m_capacity * sizeof(cl_float2)};
+
+    m_host.resize(m_capacity);
+
+    m_out << "t,fx,fy,cd,cl\n";
+}
+
+void ForceRecorder::update_interfaces(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& boundary) {
+    queue.enqueueFillBuffer(m_count, cl_uint{0}, 0, sizeof(cl_uint));
+
+    m_kernel_compact.setArg(0, boundary);
+    m_kernel_compact.setArg(1, m_list);
+    m_kernel_compact.setArg(2, m_count);
+
+    tracer.enqueue(queue, m_kernel_compact, cl::NDRange(m_size.x, m_size.y), cl::NullRange);
+
+    cl_uint count = 0;
+    queue.enqueueReadBuffer(m_count, CL_TRUE, 0, sizeof(cl_uint), &count);
+    m_num_interfaces = count;
+}
+
+void ForceRecorder::record(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& p,
+                           cl::Buffer const& u, cl::Buffer const& v, rvec2 mesh, real_t re, real_t t)
+{
+    cl_int2 size = {{ m_size.x, m_size.y }};
+    cl_float2 h = {{ static_cast<cl_float>(mesh.x), static_cast<cl_float>(mesh.y) }};
+
+    m_kernel_integrate.setArg(0, m_list);
+    m_kernel_integrate.setArg(1, static_cast<cl_uint>(m_num_interfaces));
+    m_kernel_integrate.setArg(2, p);
+    m_kernel_integrate.setArg(3, u);
+    m_kernel_integrate.setArg(4, v);
+    m_kernel_integrate.setArg(5, size);
+    m_kernel_integrate.setArg(6, h);
+    m_kernel_integrate.setArg(7, static_cast<cl_float>(re));
+    m_kernel_integrate.setArg(8, m_series);
+    m_kernel_integrate.setArg(9, static_cast<cl_uint>(m_times.size()));
+    m_kernel_integrate.setArg(10, cl::Local(FORCES_LOCAL_SIZE * sizeof(cl_float2)));
+
+    tracer.enqueue(queue, m_kernel_integrate, cl::NDRange(FORCES_LOCAL_SIZE), cl::NDRange(FORCES_LOCAL_SIZE));
+
+    m_times.push_back(t);
+    if (m_times.size() == m_capacity) {
+        flush(queue);
+    }
+}
+
+void ForceRecorder::flush(cl::CommandQueue const& queue) {
+    if (!m_times.empty()) {
+        queue.enqueueReadBuffer(m_series, CL_TRUE, 0, m_times.size() * sizeof(cl_float2), m_host.data());
+
+        for (std::size_t i = 0; i < m_times.size(); i++) {
+            auto const fx = m_host[i].s[0];
+            auto const fy = m_host[i].s[1];
+
+            m_out << m_times[i] << "," << fx << "," << fy << ","
+                  << fx * m_coeff_scale << "," << fy * m_coeff_scale << "\n";
+        }
+
+        m_times.clear();
+    }
+
+    m_out.flush();
+}
+
+}   /* namespace core */
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/trace.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace core {
+
+//! Records the total force acting on obstacles (drag and lift) over time.
+//!
+//! The fluid/obstacle interface is extracted once per geometry into a compact
+//! list on the device. Each step, a single reduction over this list writes
+//! the force into a device time-series buffer, which is only read back when
+//! full and on flush.
+class ForceRecorder {
+public:
+    //! Coefficients are computed as `2 F / (u_ref^2 * l_ref)`.
+    ForceRecorder(cl::Context const& context, cl::Program const& program, std::string const& output,
+                  real_t u_ref, real_t l_ref, ivec2 size, uint_t capacity = 1024);
+
+    //! Extracts the interface cells from the given boundary buffer. Has to be
+    //! called initially and after each change of the geometry.
+    void update_interfaces(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& boundary);
+
+    //! Enqueues the force integration for the current state at time `t` via the tracer.
+    void record(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& p, cl::Buffer const& u,
+                cl::Buffer const& v, rvec2 mesh, real_t re, real_t t);
+
+    //! Writes all recorded samples, blocks until done.
+    void flush(cl::CommandQueue const& queue);
+
+    auto num_interfaces() const -> uint_t;
+
+private:
+    ivec2 m_size;
+    real_t m_coeff_scale;
+    std::ofstream m_out;
+
+    cl::Kernel m_kernel_compact;
+    cl::Kernel m_kernel_integrate;
+
+    cl::Buffer m_list;
+    cl::Buffer m_count;
+    cl::Buffer m_series;
+
+    uint_t m_num_interfaces;
+    uint_t m_capacity;
+
+    std::vector<real_t> m_times;
+    std::vector<cl_float2> m_host;
+};
+
+
+inline auto ForceRecorder::num_interfaces() const -> uint_t {
+    return m_num_interfaces;
+}
+
+}   /* namespace core */
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+
+namespace core {
+
+//! Procedural geometries that can be evaluated directly on the device.
+enum class GeneratorType {
+    None,
+    ChannelStep,
+    Cylinders,
+    Porous,
+    Karman,
+};
+
+//! Parameters for procedural geometry generation.
+//!
+//! All generators produce a channel (inflow left, outflow right, no-slip
+//! top and bottom) with obstacles inside. Positions and lengths are given
+//! in physical units, i.e. relative to the geometry length.
+struct Generator {
+    GeneratorType type = GeneratorType::None;
+
+    // channel with backward-facing step at the inflow (width, height)
+    rvec2  step     = {0.25, 0.5};
+
+    // cylinder array (also used for the Karman vortex street setup, see `Geometry::load()` for its defaults)
+    rvec2  center   = {0.2, 0.5};
+    ivec2  count    = {1, 1};
+    rvec2  spacing  = {0.2, 0.2};
+    real_t radius   = 0.05;
+
+    // random porous medium: grains of the given cell size in [start, end]
+    rvec2  start    = {0.2, 0.0};
+    rvec2  end      = {0.8, 1.0};
+    real_t grain    = 0.05;
+    real_t density  = 0.6;
+    uint_t seed     = 0;
+};
+
+
+namespace generator {
+
+inline auto type_from_string(std::string const& name) -> GeneratorType {
+    if (name == "channel_step") { return GeneratorType::ChannelStep; }
+    if (name == "cylinders")    { return GeneratorType::Cylinders;   }
+    if (name == "porous")       { return GeneratorType::Porous;      }
+    if (name == "karman")       { return GeneratorType::Karman;      }
+
+    std::stringstream msg;
+    msg << "Unknown geometry generator `" << name << "`";
+    throw std::invalid_argument(msg.str());
+}
+
+}   /* namespace generator */
+}   /* namespace core */
@@ -1,5 +1,6 @@
 #include "core/geometry.hpp"
 #include "utils/trim.hpp"
+#include "utils/thread_pool.hpp"
 
 #include <fstream>
 #include <algorithm>
@@ -7,43 +8,80 @@
 
 namespace core {
 namespace geometry {
+namespace {
+
+//! Minimum number of cells per block for the parallel neighbor-bit computation.
+const std::ptrdiff_t NEIGHBOR_BITS_GRAIN = 64 * 1024;
+
+inline auto is_fluid(std::uint8_t cell) -> bool {
+    return (cell & CELL_MASK_SELF) == static_cast<std::uint8_t>(CellType::Fluid);
+}
+
+//! Computes the neighbor bits for the cells in rows `[y_begin, y_end)` and
+//! columns `[x_begin, x_end)` from `src` and writes the resulting cells to
+//! `dst`, which starts at `(x_begin, y_begin)` and has a row-stride of
+//! `dst_stride`.
+void compute_neighbor_bits(ivec2 const& size, std::uint8_t const* src, std::uint8_t* dst, std::size_t dst_stride,
+                           int_t x_begin, int_t x_end, int_t y_begin, int_t y_end)
+{
+    for (int_t y = y_begin; y < y_end; y++) {
+        std::uint8_t const* row = src + static_cast<std::size_t>(y) * size.x;
+        std::uint8_t const* row_below = (y != 0) ? row - size.x : row;
+        std::uint8_t const* row_above = (y != (size.y - 1)) ? row + size.x : row;
+
+        std::uint8_t* out = dst + static_cast<std::size_t>(y - y_begin) * dst_stride;
+
+        for (int_t x = x_begin; x < x_end; x++) {
+            std::uint8_t cell = row[x] & CELL_MASK_SELF;
+
+            if (x != 0 && is_fluid(row[x - 1]))                 { cell |= CELL_MASK_NEIGHBOR_LEFT;   }
+            if (x != (size.x - 1) && is_fluid(row[x + 1]))      { cell |= CELL_MASK_NEIGHBOR_RIGHT;  }
+            if (y != 0 && is_fluid(row_below[x]))               { cell |= CELL_MASK_NEIGHBOR_BOTTOM; }
+            if (y != (size.y - 1) && is_fluid(row_above[x]))    { cell |= CELL_MASK_NEIGHBOR_TOP;    }
+
+            out[x - x_begin] = cell;
+        }
+    }
+}
+
+}   /* namespace */
+
 
 void set_neighbor_bits(ivec2 const& size, std::vector<std::uint8_t>& data) {
-    auto idx = [&](ivec2 pos) -> std::size_t {
-        return pos.y * size.x + pos.x;
-    };
+    // write to separate output so that blocks never read cells being written by other blocks
+    std::vector<std::uint8_t> result(data.size());
 
-    auto is_fluid = [&](ivec2 pos) -> bool {
-        return (data[idx(pos)] & CELL_MASK_SELF) == static_cast<std::uint8_t>(CellType::Fluid);
-    };
+    std::ptrdiff_t const grain_rows = std::max<std::ptrdiff_t>(1, NEIGHBOR_BITS_GRAIN / std::max<int_t>(size.x, 1));
 
-    for (int_t y = 0; y < size.y; y++) {
-        for (int_t x = 0; x < size.x; x++) {
-            std::uint8_t neighbors = 0b0000;
+    utils::ThreadPool::global().parallel_for(0, size.y, grain_rows, [&](std::ptrdiff_t y_begin, std::ptrdiff_t y_end) {
+        std::uint8_t* dst = result.data() + static_cast<std::size_t>(y_begin) * size.x;
+        compute_neighbor_bits(size, data.data(), dst, size.x, 0, size.x, y_begin, y_end);
+    });
 
-            // left neighbor
-            if (x != 0 && is_fluid({x - 1, y})) {
-                neighbors |= CELL_MASK_NEIGHBOR_LEFT;
-            }
+    data = std::move(result);
+}
 
-            // right neighbor
-            if (x != (size.x - 1) && is_fluid({x + 1, y})) {
-                neighbors |= CELL_MASK_NEIGHBOR_RIGHT;
-            }
+void set_neighbor_bits(ivec2 const& size, std::vector<std::uint8_t>& data, Rect const& region) {
+    Rect const r = rect_clip(region, {{0, 0}, size});
+    if (rect_is_empty(r)) {
+        return;
+    }
 
-            // bottom neighbor
-            if (y != 0 && is_fluid({x, y - 1})) {
-                neighbors |= CELL_MASK_NEIGHBOR_BOTTOM;
-            }
+    // compute into scratch buffer first, cells outside the region are only read
+    ivec2 const r_size = {r.max.x - r.min.x, r.max.y - r.min.y};
+    std::vector<std::uint8_t> result(static_cast<std::size_t>(r_size.x) * r_size.y);
 
-            // top neighbor
-            if (y != (size.y - 1) && is_fluid({x, y + 1})) {
-                neighbors |= CELL_MASK_NEIGHBOR_TOP;
-            }
+    std::ptrdiff_t const grain_rows = std::max<std::ptrdiff_t>(1, NEIGHBOR_BITS_GRAIN / r_size.x);
 
-            // clear and set
-            data[idx({x, y})] = (data[idx({x, y})] & CELL_MASK_SELF) | neighbors;
-        }
+    utils::ThreadPool::global().parallel_for(r.min.y, r.max.y, grain_rows, [&](std::ptrdiff_t y_begin, std::ptrdiff_t y_end) {
+        std::uint8_t* dst = result.data() + static_cast<std::size_t>(y_begin - r.min.y) * r_size.x;
+        compute_neighbor_bits(size, data.data(), dst, r_size.x, r.min.x, r.max.x, y_begin, y_end);
+    });
+
+    for (int_t y = 0; y < r_size.y; y++) {
+        auto src = result.begin() + static_cast<std::size_t>(y) * r_size.x;
+        auto dst = data.begin() + static_cast<std::size_t>(r.min.y + y) * size.x + r.min.x;
+        std::copy(src, src + r_size.x, dst);
     }
 }
 
@@ -54,7 +92,7 @@ void Geometry::make_lid_driven_cavity() {
         return pos.y * m_size.x + pos.x;
     };
 
-    std::fill(m_data.begin(), m_data.end(), geometry::cell_type_to_bits(CellType::Fluid));
+    m_data.assign(m_size.x * m_size.y, geometry::cell_type_to_bits(CellType::Fluid));
 
     // set left boundary: no-slip
     for (int_t y = 0; y < m_size.y; y++) {
@@ -93,6 +131,9 @@ void Geometry::load(char const* file) {
 
     std::vector<char> freeform;
 
+    // cylinder parameters given explicitly, others default to the Karman setup
+    bool has_center = false, has_count = false, has_spacing = false, has_radius = false;
+
     while (in) {
         std::string line;
         if (!std::getline(in, line)) { break; }
@@ -133,8 +174,78 @@ void Geometry::load(char const* file) {
                     if (!std::getline(in, line)) { break; }
                     std::copy(line.begin(), line.end(), std::back_inserter(freeform));
                 }
+            } else {                    // procedural geometry
+                m_generator.type = generator::type_from_string(value);
             }
         }
+
+        // generator parameters
+        if (key == "step") {
+            tokenstr >> m_generator.step.x;
+            tokenstr >> m_generator.step.y;
+        }
+
+        if (key == "center") {
+            tokenstr >> m_generator.center.x;
+            tokenstr >> m_generator.center.y;
+            has_center = true;
+        }
+
+        if (key == "count") {
+            tokenstr >> m_generator.count.x;
+            tokenstr >> m_generator.count.y;
+            has_count = true;
+        }
+
+        if (key == "spacing") {
+            tokenstr >> m_generator.spacing.x;
+            tokenstr >> m_generator.spacing.y;
+            has_spacing = true;
+        }
+
+        if (key == "radius") {
+            tokenstr >> m_generator.radius;
+            has_radius = true;
+        }
+
+        if (key == "start") {
+            tokenstr >> m_generator.start.x;
+            tokenstr >> m_generator.start.y;
+        }
+
+        if (key == "end") {
+            tokenstr >> m_generator.end.x;
+            tokenstr >> m_generator.end.y;
+        }
+
+        if (key == "grain") {
+            tokenstr >> m_generator.grain;
+        }
+
+        if (key == "density") {
+            tokenstr >> m_generator.density;
+        }
+
+        if (key == "seed") {
+            tokenstr >> m_generator.seed;
+        }
+    }
+
+    // Karman vortex street: single cylinder, slightly off-center to trigger shedding, relative to the length
+    if (m_generator.type == GeneratorType::Karman) {
+        if (!has_center)  { m_generator.center  = {0.2f * m_length.x, 0.52f * m_length.y}; }
+        if (!has_count)   { m_generator.count   = {1, 1}; }
+        if (!has_spacing) { m_generator.spacing = m_length; }
+        if (!has_radius)  { m_generator.radius  = 0.1f * m_length.y; }
+    }
+
+    // cylinder array: the nearest cylinder is found by dividing by the spacing and clamping to the count
+    if (m_generator.count.x < 1 || m_generator.count.y < 1) {
+        throw std::invalid_argument{"Generator cylinder count must be at least one"};
+    }
+
+    if (!(m_generator.spacing.x > 0 && m_generator.spacing.y > 0)) {
+        throw std::invalid_argument{"Generator cylinder spacing must be positive"};
     }
 
     // update mesh-width
@@ -165,12 +276,41 @@ void Geometry::load(char const* file) {
         // reset neighbor bits
         geometry::set_neighbor_bits(m_size, m_data);
 
+    // procedural geometry is generated on the device, don't keep host data
+    } else if (is_procedural()) {
+        m_data.clear();
+        m_data.shrink_to_fit();
+
     // else make/update the lid driven cavity form
     } else {
         make_lid_driven_cavity();
     }
 }
 
+void Geometry::paint(geometry::Rect const& region, CellType type) {
+    // never touch the outer boundary
+    geometry::Rect const r = geometry::rect_clip(region, {{1, 1}, {m_size.x - 1, m_size.y - 1}});
+    if (geometry::rect_is_empty(r)) {
+        return;
+    }
+
+    std::uint8_t const bits = geometry::cell_type_to_bits(type);
+    for (int_t y = r.min.y; y < r.max.y; y++) {
+        for (int_t x = r.min.x; x < r.max.x; x++) {
+            m_data[y * m_size.x + x] = bits;
+        }
+    }
+
+    // neighbor bits change in the region plus a one-cell margin
+    geometry::Rect const affected = geometry::rect_clip(
+        {{r.min.x - 1, r.min.y - 1}, {r.max.x + 1, r.max.y + 1}},
+        {{0, 0}, m_size}
+    );
+
+    geometry::set_neighbor_bits(m_size, m_data, affected);
+    m_dirty = geometry::rect_union(m_dirty, affected);
+}
+
 auto Geometry::num_fluid_cells() const -> uint_t {
     return std::count_if(m_data.begin(), m_data.end(), [](std::uint8_t c) {
         return (c & CELL_MASK_SELF) == geometry::cell_type_to_bits(CellType::Fluid);
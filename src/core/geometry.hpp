@@ -1,7 +1,9 @@
 #pragma once
 
 #include "types.hpp"
+#include "core/generator.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <bitset>
 #include <stdexcept>
@@ -30,11 +32,22 @@ const std::uint8_t CELL_MASK_SELF            = 0b00001111;
 
 namespace geometry {
 
+//! Rectangular region of cells, `min` is inclusive, `max` is exclusive.
+struct Rect {
+    ivec2 min;
+    ivec2 max;
+};
+
 inline auto cell_type_to_bits(CellType type) -> std::uint8_t;
 inline auto cell_type_from_char(char c) -> CellType;
 inline auto cell_type_to_char(CellType type) -> char;
 
+inline auto rect_is_empty(Rect const& rect) -> bool;
+inline auto rect_union(Rect const& a, Rect const& b) -> Rect;
+inline auto rect_clip(Rect const& rect, Rect const& bounds) -> Rect;
+
 void set_neighbor_bits(ivec2 const& size, std::vector<std::uint8_t>& data);
+void set_neighbor_bits(ivec2 const& size, std::vector<std::uint8_t>& data, Rect const& region);
 
 }   /* namespace geometry */
 
@@ -63,6 +76,23 @@ public:
     inline auto data() const -> std::vector<std::uint8_t> const&;
     auto num_fluid_cells() const -> uint_t;
 
+    //! Procedural generator for this geometry. If set, `data()` is empty
+    //! until assigned via `set_data()`, e.g. after generation on the device.
+    inline auto generator() const -> Generator const&;
+    inline auto is_procedural() const -> bool;
+    inline void set_data(std::vector<std::uint8_t> data);
+
+    //! Sets the cells in the given region to `type`. The region is clipped to
+    //! the interior of the domain, outer boundary cells are never modified.
+    void paint(geometry::Rect const& region, CellType type);
+    inline void erase(geometry::Rect const& region);
+
+    //! Returns the region of cells (including neighbor bits) changed since
+    //! the last call to `clear_dirty()`.
+    inline auto dirty_region() const -> geometry::Rect const&;
+    inline auto is_dirty() const -> bool;
+    inline void clear_dirty();
+
 private:
     void make_lid_driven_cavity();
 
@@ -75,6 +105,9 @@ private:
     real_t m_pressure;
 
     std::vector<std::uint8_t> m_data;
+    geometry::Rect m_dirty;
+
+    Generator m_generator;
 };
 
 
@@ -118,6 +151,27 @@ inline auto cell_type_to_char(CellType type) -> char {
     throw std::invalid_argument(msg.str());
 }
 
+inline auto rect_is_empty(Rect const& rect) -> bool {
+    return rect.min.x >= rect.max.x || rect.min.y >= rect.max.y;
+}
+
+inline auto rect_union(Rect const& a, Rect const& b) -> Rect {
+    if (rect_is_empty(a)) { return b; }
+    if (rect_is_empty(b)) { return a; }
+
+    return {
+        {std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+        {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)},
+    };
+}
+
+inline auto rect_clip(Rect const& rect, Rect const& bounds) -> Rect {
+    return {
+        {std::max(rect.min.x, bounds.min.x), std::max(rect.min.y, bounds.min.y)},
+        {std::min(rect.max.x, bounds.max.x), std::min(rect.max.y, bounds.max.y)},
+    };
+}
+
 }   /* namespace geometry */
 
 
@@ -127,7 +181,8 @@ Geometry::Geometry(ivec2 size, rvec2 length, rvec2 velocity, real_t pressure, st
     , m_length{length}
     , m_velocity{velocity}
     , m_pressure{pressure}
-    , m_data{std::move(data)} {}
+    , m_data{std::move(data)}
+    , m_dirty{{0, 0}, {0, 0}} {}
 
 auto Geometry::size() const -> ivec2 const& {
     return m_size;
@@ -153,4 +208,36 @@ auto Geometry::data() const -> std::vector<std::uint8_t> const& {
     return m_data;
 }
 
+auto Geometry::generator() const -> Generator const& {
+    return m_generator;
+}
+
+auto Geometry::is_procedural() const -> bool {
+    return m_generator.type != GeneratorType::None;
+}
+
+void Geometry::set_data(std::vector<std::uint8_t> data) {
+    if (data.size() != static_cast<std::size_t>(m_size.x) * m_size.y) {
+        throw std::invalid_argument{"Geometry size does not match data"};
+    }
+
+    m_data = std::move(data);
+}
+
+void Geometry::erase(geometry::Rect const& region) {
+    paint(region, CellType::Fluid);
+}
+
+auto Geometry::dirty_region() const -> geometry::Rect const& {
+    return m_dirty;
+}
+
+auto Geometry::is_dirty() const -> bool {
+    return !geometry::rect_is_empty(m_dirty);
+}
+
+void Geometry::clear_dirty() {
+    m_dirty = {{0, 0}, {0, 0}};
+}
+
 }   /* namespace core */
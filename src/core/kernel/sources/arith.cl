@@ -0,0 +1,14 @@
+//! Kernels for element-wise arithmetic on buffers.
+//!
+
+
+//! Computes the linear combination `y = a * x + b * y`.
+__kernel void axpby(
+    __global const float* x,
+    __global float* y,
+    const float a,
+    const float b
+) {
+    const int i = get_global_id(0);
+    y[i] = a * x[i] + b * y[i];
+}
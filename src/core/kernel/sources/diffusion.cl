@@ -0,0 +1,109 @@
+//! Red-black Gauss-Seidel kernels for implicit diffusion.
+//!
+//! Solves `(I - dt/Re * laplace) F = F*` for the preliminary velocities, where
+//! `F*` is the result of the explicit (convective) part of the step. The
+//! boundary values of F have to be updated after each iteration.
+//!
+
+
+//! Cell color definitions:
+//!   ((pos.x + pos.y) & 1) == 0  => red
+//!   ((pos.x + pos.y) & 1) == 1  => black
+
+
+#define BC_MASK_SELF                    0b00001111
+#define BC_SELF_FLUID                   0b0000
+
+#define BC_MASK_NEIGHBOR_RIGHT          0b01000000
+#define BC_MASK_NEIGHBOR_TOP            0b00010000
+
+#define BC_IS_NEIGHBOR_RIGHT_FLUID(x)   ((x) & (BC_MASK_NEIGHBOR_RIGHT))
+#define BC_IS_NEIGHBOR_TOP_FLUID(x)     ((x) & (BC_MASK_NEIGHBOR_TOP))
+
+
+//! Converts a two-dimensional index to a linear index.
+#define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
+
+
+//! Performs a Gauss-Seidel half-sweep of the given color on F.
+//!
+//! Grid sizes:
+//! - f, f_rhs: (n + 3) * (m + 2)
+//! - b: (n + 2) * (m + 2)
+//!
+//! with `c = dt / (re * h^2)`.
+//!
+__kernel void diffuse_f(
+    __global float* f,
+    __global const float* f_rhs,
+    __global const uchar* b,
+    const float2 c,
+    const int color
+) {
+    const int2 pos = (int2)(get_global_id(0) + 1, get_global_id(1));
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+
+    if (((pos.x + pos.y) & 1) != color) {
+        return;
+    }
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x - 1, pos.y, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_RIGHT_FLUID(b_center)) {
+        return;
+    }
+
+    const float f_left  = f[INDEX(pos.x - 1, pos.y, u_size_x)];
+    const float f_right = f[INDEX(pos.x + 1, pos.y, u_size_x)];
+    const float f_down  = f[INDEX(pos.x, pos.y - 1, u_size_x)];
+    const float f_top   = f[INDEX(pos.x, pos.y + 1, u_size_x)];
+
+    const float rhs = f_rhs[INDEX(pos.x, pos.y, u_size_x)];
+
+    const float val = (rhs + c.x * (f_left + f_right) + c.y * (f_down + f_top)) / (1.0 + 2.0 * (c.x + c.y));
+    f[INDEX(pos.x, pos.y, u_size_x)] = val;
+}
+
+
+//! Performs a Gauss-Seidel half-sweep of the given color on G.
+//!
+//! Grid sizes:
+//! - g, g_rhs: (n + 2) * (m + 3)
+//! - b: (n + 2) * (m + 2)
+//!
+//! with `c = dt / (re * h^2)`.
+//!
+__kernel void diffuse_g(
+    __global float* g,
+    __global const float* g_rhs,
+    __global const uchar* b,
+    const float2 c,
+    const int color
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1) + 1);
+
+    const int b_size_x = get_global_size(0);
+    const int v_size_x = b_size_x;
+
+    if (((pos.x + pos.y) & 1) != color) {
+        return;
+    }
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x, pos.y - 1, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_TOP_FLUID(b_center)) {
+        return;
+    }
+
+    const float g_left  = g[INDEX(pos.x - 1, pos.y, v_size_x)];
+    const float g_right = g[INDEX(pos.x + 1, pos.y, v_size_x)];
+    const float g_down  = g[INDEX(pos.x, pos.y - 1, v_size_x)];
+    const float g_top   = g[INDEX(pos.x, pos.y + 1, v_size_x)];
+
+    const float rhs = g_rhs[INDEX(pos.x, pos.y, v_size_x)];
+
+    const float val = (rhs + c.x * (g_left + g_right) + c.y * (g_down + g_top)) / (1.0 + 2.0 * (c.x + c.y));
+    g[INDEX(pos.x, pos.y, v_size_x)] = val;
+}
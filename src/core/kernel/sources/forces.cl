@@ -0,0 +1,153 @@
+//! Kernels for the integration of obstacle forces (drag and lift).
+//!
+//! See `boundaries.cl` for a description of the boundary bit format.
+//!
+
+
+#define BC_MASK_SELF                    0b00001111
+#define BC_SELF_FLUID                   0b0000
+
+#define BC_SHIFT_NEIGHBORS              4
+
+//! Neighbor bits after shifting by BC_SHIFT_NEIGHBORS.
+#define IF_NEIGHBOR_LEFT                0b1000
+#define IF_NEIGHBOR_RIGHT               0b0100
+#define IF_NEIGHBOR_BOTTOM              0b0010
+#define IF_NEIGHBOR_TOP                 0b0001
+
+
+//! Converts a two-dimensional index to a linear index.
+#define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
+
+
+//! Collects all obstacle cells adjacent to fluid into a compact list.
+//!
+//! Each entry holds the linear cell index (upper bits) and the neighbor bits
+//! (lower four bits). Cells of the outer boundary are excluded, thus only
+//! obstacles inside the domain contribute. `count` has to be initialized
+//! with zero.
+//!
+//! Grid sizes:
+//! - b: (n + 2) * (m + 2)
+//! - list: at most (n + 2) * (m + 2) entries
+//!
+__kernel void compact_interfaces(
+    __global const uchar* b,
+    __global uint* list,
+    __global uint* count
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const int2 size = (int2)(get_global_size(0), get_global_size(1));
+
+    if (pos.x == 0 || pos.y == 0 || pos.x == (size.x - 1) || pos.y == (size.y - 1)) {
+        return;
+    }
+
+    const int idx = INDEX(pos.x, pos.y, size.x);
+    const uchar cell = b[idx];
+    const uint neighbors = cell >> BC_SHIFT_NEIGHBORS;
+
+    if ((cell & BC_MASK_SELF) == BC_SELF_FLUID || neighbors == 0) {
+        return;
+    }
+
+    const uint k = atomic_inc(count);
+    list[k] = ((uint)idx << BC_SHIFT_NEIGHBORS) | neighbors;
+}
+
+
+//! Integrates pressure and viscous wall stresses over all interface faces
+//! and stores the total force acting on the obstacles in `series[slot]`.
+//!
+//! The face pressure is taken from the adjacent fluid cell, the wall shear
+//! stress is approximated from the tangential velocity at the center of the
+//! adjacent fluid cell and the no-slip condition at the face. Must be
+//! launched with a single work-group.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - p: (n + 2) * (m + 2), given as `size`
+//!
+__kernel void integrate_forces(
+    __global const uint* list,
+    const uint n,
+    __global const float* p,
+    __global const float* u,
+    __global const float* v,
+    const int2 size,
+    const float2 h,
+    const float re,
+    __global float2* series,
+    const uint slot,
+    __local float2* shared
+) {
+    const int local_idx = get_local_id(0);
+    const int local_len = get_local_size(0);
+
+    const int u_size_x = size.x + 1;
+    const int v_size_x = size.x;
+
+    // wall shear stress factors: 2 / (re * h) for the half-cell distance
+    const float tau_x = 2.0 / (re * h.x);
+    const float tau_y = 2.0 / (re * h.y);
+
+    // Stage 1: Serial accumulation over interface cells
+    float2 acc = (float2)(0.0, 0.0);
+    for (int i = local_idx; i < n; i += local_len) {
+        const uint entry = list[i];
+        const int idx = entry >> BC_SHIFT_NEIGHBORS;
+        const uint neighbors = entry & 0b1111;
+
+        const int2 pos = (int2)(idx % size.x, idx / size.x);
+
+        if (neighbors & IF_NEIGHBOR_RIGHT) {        // face normal: +x
+            const int2 f = pos + (int2)(1, 0);
+            const float v_c = (v[INDEX(f.x, f.y, v_size_x)] + v[INDEX(f.x, f.y + 1, v_size_x)]) / 2.0;
+
+            acc.x -= p[INDEX(f.x, f.y, size.x)] * h.y;
+            acc.y += tau_x * v_c * h.y;
+        }
+
+        if (neighbors & IF_NEIGHBOR_LEFT) {         // face normal: -x
+            const int2 f = pos - (int2)(1, 0);
+            const float v_c = (v[INDEX(f.x, f.y, v_size_x)] + v[INDEX(f.x, f.y + 1, v_size_x)]) / 2.0;
+
+            acc.x += p[INDEX(f.x, f.y, size.x)] * h.y;
+            acc.y += tau_x * v_c * h.y;
+        }
+
+        if (neighbors & IF_NEIGHBOR_TOP) {          // face normal: +y
+            const int2 f = pos + (int2)(0, 1);
+            const float u_c = (u[INDEX(f.x, f.y, u_size_x)] + u[INDEX(f.x + 1, f.y, u_size_x)]) / 2.0;
+
+            acc.y -= p[INDEX(f.x, f.y, size.x)] * h.x;
+            acc.x += tau_y * u_c * h.x;
+        }
+
+        if (neighbors & IF_NEIGHBOR_BOTTOM) {       // face normal: -y
+            const int2 f = pos - (int2)(0, 1);
+            const float u_c = (u[INDEX(f.x, f.y, u_size_x)] + u[INDEX(f.x + 1, f.y, u_size_x)]) / 2.0;
+
+            acc.y += p[INDEX(f.x, f.y, size.x)] * h.x;
+            acc.x += tau_y * u_c * h.x;
+        }
+    }
+
+    // Stage 2: Parallel reduction
+    shared[local_idx] = acc;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int offs = (local_len >> 1); offs > 0; offs >>= 1) {
+        if (local_idx < offs) {
+            acc = acc + shared[local_idx + offs];
+            shared[local_idx] = acc;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // Write-back result
+    if (local_idx == 0) {
+        series[slot] = acc;
+    }
+}
@@ -0,0 +1,245 @@
+//! Kernels for geometry (boundary bit-field) preparation.
+//!
+//! See `boundaries.cl` for a description of the boundary bit format.
+//!
+
+
+#define BC_MASK_NEIGHBOR_LEFT           0b10000000
+#define BC_MASK_NEIGHBOR_RIGHT          0b01000000
+#define BC_MASK_NEIGHBOR_BOTTOM         0b00100000
+#define BC_MASK_NEIGHBOR_TOP            0b00010000
+
+#define BC_MASK_SELF                    0b00001111
+
+#define BC_SELF_FLUID                   0b0000
+#define BC_SELF_NOSLIP                  0b1100
+#define BC_SELF_INFLOW                  0b1101
+#define BC_SELF_OUTFLOW                 0b1110
+
+#define BC_IS_SELF_FLUID(x)             (((x) & BC_MASK_SELF) == BC_SELF_FLUID)
+
+
+//! Converts a two-dimensional index to a linear index.
+#define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
+
+
+//! Computes the neighbor-is-fluid bits from the self-tags of the cells.
+//!
+//! Only the self-tag of the input cells is used, any neighbor bits in the
+//! input are ignored. Outer boundary cells never get neighbor bits for their
+//! respective boundary.
+//!
+//! Grid sizes:
+//! - b_in, b_out: (n + 2) * (m + 2)
+//!
+__kernel void set_neighbor_bits(
+    __global const uchar* b_in,
+    __global uchar* b_out
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const int2 size = (int2)(get_global_size(0), get_global_size(1));
+
+    uchar cell = b_in[INDEX(pos.x, pos.y, size.x)] & BC_MASK_SELF;
+
+    if (pos.x > 0 && BC_IS_SELF_FLUID(b_in[INDEX(pos.x - 1, pos.y, size.x)])) {
+        cell |= BC_MASK_NEIGHBOR_LEFT;
+    }
+
+    if (pos.x < (size.x - 1) && BC_IS_SELF_FLUID(b_in[INDEX(pos.x + 1, pos.y, size.x)])) {
+        cell |= BC_MASK_NEIGHBOR_RIGHT;
+    }
+
+    if (pos.y > 0 && BC_IS_SELF_FLUID(b_in[INDEX(pos.x, pos.y - 1, size.x)])) {
+        cell |= BC_MASK_NEIGHBOR_BOTTOM;
+    }
+
+    if (pos.y < (size.y - 1) && BC_IS_SELF_FLUID(b_in[INDEX(pos.x, pos.y + 1, size.x)])) {
+        cell |= BC_MASK_NEIGHBOR_TOP;
+    }
+
+    b_out[INDEX(pos.x, pos.y, size.x)] = cell;
+}
+
+
+//! Integer hash (Thomas Wang), used as deterministic random number source.
+uint hash_u32(uint x) {
+    x = (x ^ 61) ^ (x >> 16);
+    x = x + (x << 3);
+    x = x ^ (x >> 4);
+    x = x * 0x27d4eb2d;
+    x = x ^ (x >> 15);
+    return x;
+}
+
+//! Returns a pseudo-random value in [0, 1) for the given grid position, seed
+//! and stream index.
+float hash_unit(const int2 pos, const uint seed, const uint stream) {
+    uint h = hash_u32(seed ^ hash_u32(stream));
+    h = hash_u32(h ^ (uint)pos.x);
+    h = hash_u32(h ^ (uint)pos.y);
+    return (float)(h >> 8) / (float)(1 << 24);
+}
+
+//! Returns the self-tag of a channel cell: inflow on the left, outflow on
+//! the right, no-slip on top and bottom, fluid in the interior.
+uchar channel_cell(const int2 pos, const int2 size) {
+    if (pos.y == 0 || pos.y == (size.y - 1)) {
+        return BC_SELF_NOSLIP;
+    } else if (pos.x == 0) {
+        return BC_SELF_INFLOW;
+    } else if (pos.x == (size.x - 1)) {
+        return BC_SELF_OUTFLOW;
+    } else {
+        return BC_SELF_FLUID;
+    }
+}
+
+//! Returns the physical position of the center of the given cell.
+float2 cell_center(const int2 pos, const float2 h) {
+    return (float2)((pos.x + 0.5) * h.x, (pos.y + 0.5) * h.y);
+}
+
+
+//! Generates a channel with a backward-facing step of the given (physical)
+//! width and height at the bottom of the inflow.
+//!
+//! Grid sizes:
+//! - b: (n + 2) * (m + 2), only self-tags are written
+//!
+__kernel void generate_channel_step(
+    __global uchar* b,
+    const float2 h,
+    const float2 step
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const int2 size = (int2)(get_global_size(0), get_global_size(1));
+
+    uchar cell = channel_cell(pos, size);
+
+    const float2 p = cell_center(pos, h);
+    if (cell == BC_SELF_FLUID && p.x < step.x && p.y < step.y) {
+        cell = BC_SELF_NOSLIP;
+    }
+
+    b[INDEX(pos.x, pos.y, size.x)] = cell;
+}
+
+
+//! Generates a channel with a regular array of `count` cylinders, starting
+//! at `center` and offset by `spacing`. Requires `radius < spacing / 2`.
+//!
+//! Grid sizes:
+//! - b: (n + 2) * (m + 2), only self-tags are written
+//!
+__kernel void generate_cylinders(
+    __global uchar* b,
+    const float2 h,
+    const float2 center,
+    const int2 count,
+    const float2 spacing,
+    const float radius
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const int2 size = (int2)(get_global_size(0), get_global_size(1));
+
+    uchar cell = channel_cell(pos, size);
+
+    // nearest cylinder of the array
+    const float2 p = cell_center(pos, h);
+    const float2 idx = clamp(round((p - center) / spacing), (float2)(0.0, 0.0), convert_float2(count - 1));
+    const float2 c = center + idx * spacing;
+
+    if (cell == BC_SELF_FLUID && distance(p, c) < radius) {
+        cell = BC_SELF_NOSLIP;
+    }
+
+    b[INDEX(pos.x, pos.y, size.x)] = cell;
+}
+
+
+//! Generates a channel with a random porous medium in the region between
+//! `start` and `end`. The region is divided into square blocks of size
+//! `grain`, each block contains a randomly placed and sized disc with
+//! probability `density`.
+//!
+//! Grid sizes:
+//! - b: (n + 2) * (m + 2), only self-tags are written
+//!
+__kernel void generate_porous(
+    __global uchar* b,
+    const float2 h,
+    const float2 start,
+    const float2 end,
+    const float grain,
+    const float density,
+    const uint seed
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const int2 size = (int2)(get_global_size(0), get_global_size(1));
+
+    uchar cell = channel_cell(pos, size);
+
+    const float2 p = cell_center(pos, h);
+    const int2 block = convert_int2(floor(p / grain));
+
+    // discs are centered in the inner half of their block with radius below
+    // 0.45 * grain, thus only the direct neighbor blocks need to be checked
+    for (int dy = -1; dy <= 1 && cell == BC_SELF_FLUID; dy++) {
+        for (int dx = -1; dx <= 1 && cell == BC_SELF_FLUID; dx++) {
+            const int2 nb = block + (int2)(dx, dy);
+
+            if (hash_unit(nb, seed, 0) >= density) {
+                continue;
+            }
+
+            const float2 jitter = (float2)(hash_unit(nb, seed, 1), hash_unit(nb, seed, 2));
+            const float2 c = (convert_float2(nb) + 0.25 + 0.5 * jitter) * grain;
+            const float r = (0.2 + 0.25 * hash_unit(nb, seed, 3)) * grain;
+
+            const bool inside = all(c >= start) && all(c <= end);
+            if (inside && distance(p, c) < r) {
+                cell = BC_SELF_NOSLIP;
+            }
+        }
+    }
+
+    b[INDEX(pos.x, pos.y, size.x)] = cell;
+}
+
+
+//! Counts the fluid cells. Each work-group reduces its cells and adds the
+//! result to `count`, which has to be initialized with zero.
+__kernel void count_fluid(
+    __global const uchar* b,
+    __global uint* count,
+    __local uint* shared,
+    const uint n
+) {
+    const int global_idx = get_global_id(0);
+    const int global_len = get_global_size(0);
+    const int local_idx = get_local_id(0);
+    const int local_len = get_local_size(0);
+
+    // Stage 1: Serial reduction (reduce to global size)
+    uint acc = 0;
+    for (int i = global_idx; i < n; i += global_len) {
+        acc += BC_IS_SELF_FLUID(b[i]) ? 1 : 0;
+    }
+
+    // Stage 2: Parallel reduction (reduce to #workgroups)
+    shared[local_idx] = acc;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int offs = (local_len >> 1); offs > 0; offs >>= 1) {
+        if (local_idx < offs) {
+            acc = acc + shared[local_idx + offs];
+            shared[local_idx] = acc;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // Stage 3: Accumulate work-group results
+    if (local_idx == 0) {
+        atomic_add(count, acc);
+    }
+}
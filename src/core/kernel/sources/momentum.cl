@@ -18,38 +18,29 @@
 #define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
 
 
-//! Computes the momentum equation for F.
-//!
-//! Grid sizes:
-//! - u, f: (n + 3) * (m + 2)   i.e. has boundaries and is staggered in x direction 
-//! - v: (n + 2) * (m + 3)      i.e. has boundaries and is staggered in y direction
-//! - b: (n + 2) * (m + 2)      i.e. has boundaries but is not staggered
-//! where n * m is the size of the interior.
-//!
-__kernel void momentum_eq_f(
+//! Computes the local pseudo-time step for a cell face from the velocities at
+//! that face, using the same stability conditions as the global time step.
+float local_dt(const float u_abs, const float v_abs, const float re, const float tau, const float dt_max, const float2 h) {
+    const float dt_diff = ((h.x * h.x * h.y * h.y) / (h.x * h.x + h.y * h.y)) * re * 0.5;
+    const float dt_conv = fmin(h.x / fmax(u_abs, 1e-6f), h.y / fmax(v_abs, 1e-6f));
+
+    return fmin(dt_max, tau * fmin(dt_diff, dt_conv));
+}
+
+
+//! Computes the right-hand side of the momentum equation for u (diffusion
+//! minus convection) at the given u position. The diffusion term is scaled
+//! by `re_inv`, i.e. it can be disabled by passing zero.
+float momentum_f_acc(
     __global const float* u,
     __global const float* v,
-    __global float* f,
-    __global const uchar* b,
+    const int2 pos,
+    const int u_size_x,
+    const int v_size_x,
     const float alpha,
-    const float re,
-    const float dt,
+    const float re_inv,
     const float2 h
 ) {
-    const int2 pos = (int2)(get_global_id(0) + 1, get_global_id(1));
-    // assumes: pos.x > 0 && pos.x < (len.x - 1) && pos.y > 0 && pos.y < (len.y - 1)
-    // with len.x = n + 3, len.y = m + 2
-
-    const int b_size_x = get_global_size(0);
-    const int u_size_x = b_size_x + 1;
-    const int v_size_x = b_size_x;
-
-    // only execute on fluid-to-fluid cell boundaries
-    const uchar b_center = b[INDEX(pos.x - 1, pos.y, b_size_x)];
-    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_RIGHT_FLUID(b_center)) {
-        return;
-    }
-
     // load u
     const float u_center     = u[INDEX(pos.x, pos.y, u_size_x)];
     const float u_left       = u[INDEX(pos.x - 1, pos.y, u_size_x)];
@@ -66,7 +57,7 @@ __kernel void momentum_eq_f(
     // dxx(u), dyy(u)
     const float dxx = (u_right - 2.0 * u_center + u_left) / (h.x * h.x);
     const float dyy = (u_top - 2.0 * u_center + u_down) / (h.y * h.y);
-    float acc = (dxx + dyy) / re;
+    float acc = (dxx + dyy) * re_inv;
 
     // dc_udu_x
     const float dc_udu_x_ar = (u_center + u_right) / 2.0;
@@ -92,42 +83,22 @@ __kernel void momentum_eq_f(
     const float dc_vdu_y = (dc_vdu_y_a / h.y) + (alpha / h.y) * dc_vdu_y_b;
     acc -= dc_vdu_y;
 
-    // store result
-    f[INDEX(pos.x, pos.y, u_size_x)] = u_center + dt * acc;
+    return acc;
 }
 
 
-//! Computes the momentum equation for G.
-//!
-//! Grid sizes:
-//! - u: (n + 3) * (m + 2)      i.e. has boundaries and is staggered in x direction 
-//! - v, g: (n + 2) * (m + 3)   i.e. has boundaries and is staggered in y direction
-//! where n * m is the size of the interior.
-//!
-__kernel void momentum_eq_g(
+//! Computes the right-hand side of the momentum equation for v (diffusion
+//! minus convection) at the given v position. See `momentum_f_acc`.
+float momentum_g_acc(
     __global const float* u,
     __global const float* v,
-    __global float* g,
-    __global const uchar* b,
+    const int2 pos,
+    const int u_size_x,
+    const int v_size_x,
     const float alpha,
-    const float re,
-    const float dt,
+    const float re_inv,
     const float2 h
 ) {
-    const int2 pos = (int2)(get_global_id(0), get_global_id(1) + 1);
-    // assumes: pos.x > 0 && pos.x < (len.x - 1) && pos.y > 0 && pos.y < (len.y - 1)
-    // with len.x = n + 2, len.y = m + 3
-
-    const int b_size_x = get_global_size(0);
-    const int u_size_x = b_size_x + 1;
-    const int v_size_x = b_size_x;
-
-    // only execute on fluid-to-fluid cell boundaries
-    const uchar b_center = b[INDEX(pos.x, pos.y - 1, b_size_x)];
-    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_TOP_FLUID(b_center)) {
-        return;
-    }
-
     // load v
     const float v_center   = v[INDEX(pos.x, pos.y, v_size_x)];
     const float v_left     = v[INDEX(pos.x - 1, pos.y, v_size_x)];
@@ -144,7 +115,7 @@ __kernel void momentum_eq_g(
     // dxx(v), dyy(v)
     const float dxx = (v_right - 2.0 * v_center + v_left) / (h.x * h.x);
     const float dyy = (v_top - 2.0 * v_center + v_down) / (h.y * h.y);
-    float acc = (dxx + dyy) / re;
+    float acc = (dxx + dyy) * re_inv;
 
     // dc_vdv_y
     const float dc_vdv_y_at = (v_center + v_top) / 2.0;
@@ -170,6 +141,251 @@ __kernel void momentum_eq_g(
     const float dc_udv_x = (dc_udv_x_a / h.x) + (alpha / h.x) * dc_udv_x_b;
     acc -= dc_udv_x;
 
+    return acc;
+}
+
+
+//! Computes the momentum equation for F.
+//!
+//! Grid sizes:
+//! - u, f: (n + 3) * (m + 2)   i.e. has boundaries and is staggered in x direction 
+//! - v: (n + 2) * (m + 3)      i.e. has boundaries and is staggered in y direction
+//! - b: (n + 2) * (m + 2)      i.e. has boundaries but is not staggered
+//! where n * m is the size of the interior.
+//!
+__kernel void momentum_eq_f(
+    __global const float* u,
+    __global const float* v,
+    __global float* f,
+    __global const uchar* b,
+    const float alpha,
+    const float re,
+    const float dt,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0) + 1, get_global_id(1));
+    // assumes: pos.x > 0 && pos.x < (len.x - 1) && pos.y > 0 && pos.y < (len.y - 1)
+    // with len.x = n + 3, len.y = m + 2
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x - 1, pos.y, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_RIGHT_FLUID(b_center)) {
+        return;
+    }
+
+    const float u_center = u[INDEX(pos.x, pos.y, u_size_x)];
+    const float acc = momentum_f_acc(u, v, pos, u_size_x, v_size_x, alpha, 1.0 / re, h);
+
+    // store result
+    f[INDEX(pos.x, pos.y, u_size_x)] = u_center + dt * acc;
+}
+
+
+//! Computes the momentum equation for G.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)      i.e. has boundaries and is staggered in x direction 
+//! - v, g: (n + 2) * (m + 3)   i.e. has boundaries and is staggered in y direction
+//! where n * m is the size of the interior.
+//!
+__kernel void momentum_eq_g(
+    __global const float* u,
+    __global const float* v,
+    __global float* g,
+    __global const uchar* b,
+    const float alpha,
+    const float re,
+    const float dt,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1) + 1);
+    // assumes: pos.x > 0 && pos.x < (len.x - 1) && pos.y > 0 && pos.y < (len.y - 1)
+    // with len.x = n + 2, len.y = m + 3
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x, pos.y - 1, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_TOP_FLUID(b_center)) {
+        return;
+    }
+
+    const float v_center = v[INDEX(pos.x, pos.y, v_size_x)];
+    const float acc = momentum_g_acc(u, v, pos, u_size_x, v_size_x, alpha, 1.0 / re, h);
+
     // store result
     g[INDEX(pos.x, pos.y, b_size_x)] = v_center + dt * acc;
 }
+
+
+//! Computes the momentum equation for F with a local pseudo-time step.
+//!
+//! Used for steady-state computations: the current pressure gradient is
+//! included in F, so that the subsequent projection only needs to solve for a
+//! pressure increment. The time step is computed per face from the local
+//! velocities, limited by `dt_max`.
+//!
+//! Grid sizes:
+//! - u, f: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - p, b: (n + 2) * (m + 2)
+//!
+__kernel void momentum_eq_f_local(
+    __global const float* u,
+    __global const float* v,
+    __global const float* p,
+    __global float* f,
+    __global const uchar* b,
+    const float alpha,
+    const float re,
+    const float tau,
+    const float dt_max,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0) + 1, get_global_id(1));
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x - 1, pos.y, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_RIGHT_FLUID(b_center)) {
+        return;
+    }
+
+    const float u_center = u[INDEX(pos.x, pos.y, u_size_x)];
+    const float v_avg = (v[INDEX(pos.x - 1, pos.y + 1, v_size_x)] + v[INDEX(pos.x, pos.y + 1, v_size_x)]
+                       + v[INDEX(pos.x - 1, pos.y, v_size_x)] + v[INDEX(pos.x, pos.y, v_size_x)]) / 4.0;
+
+    const float p_dx = (p[INDEX(pos.x, pos.y, b_size_x)] - p[INDEX(pos.x - 1, pos.y, b_size_x)]) / h.x;
+
+    const float dt = local_dt(fabs(u_center), fabs(v_avg), re, tau, dt_max, h);
+    const float acc = momentum_f_acc(u, v, pos, u_size_x, v_size_x, alpha, 1.0 / re, h);
+
+    f[INDEX(pos.x, pos.y, u_size_x)] = u_center + dt * (acc - p_dx);
+}
+
+
+//! Computes the momentum equation for G with a local pseudo-time step.
+//!
+//! See `momentum_eq_f_local`.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v, g: (n + 2) * (m + 3)
+//! - p, b: (n + 2) * (m + 2)
+//!
+__kernel void momentum_eq_g_local(
+    __global const float* u,
+    __global const float* v,
+    __global const float* p,
+    __global float* g,
+    __global const uchar* b,
+    const float alpha,
+    const float re,
+    const float tau,
+    const float dt_max,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1) + 1);
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x, pos.y - 1, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_TOP_FLUID(b_center)) {
+        return;
+    }
+
+    const float v_center = v[INDEX(pos.x, pos.y, v_size_x)];
+    const float u_avg = (u[INDEX(pos.x + 1, pos.y - 1, u_size_x)] + u[INDEX(pos.x + 1, pos.y, u_size_x)]
+                       + u[INDEX(pos.x, pos.y - 1, u_size_x)] + u[INDEX(pos.x, pos.y, u_size_x)]) / 4.0;
+
+    const float p_dy = (p[INDEX(pos.x, pos.y, b_size_x)] - p[INDEX(pos.x, pos.y - 1, b_size_x)]) / h.y;
+
+    const float dt = local_dt(fabs(u_avg), fabs(v_center), re, tau, dt_max, h);
+    const float acc = momentum_g_acc(u, v, pos, u_size_x, v_size_x, alpha, 1.0 / re, h);
+
+    g[INDEX(pos.x, pos.y, b_size_x)] = v_center + dt * (acc - p_dy);
+}
+
+
+//! Computes the convective part of the momentum equation for F, i.e. the
+//! explicit part of a step with implicit diffusion.
+//!
+//! Grid sizes:
+//! - u, f: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - b: (n + 2) * (m + 2)
+//!
+__kernel void momentum_eq_f_conv(
+    __global const float* u,
+    __global const float* v,
+    __global float* f,
+    __global const uchar* b,
+    const float alpha,
+    const float dt,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0) + 1, get_global_id(1));
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x - 1, pos.y, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_RIGHT_FLUID(b_center)) {
+        return;
+    }
+
+    const float u_center = u[INDEX(pos.x, pos.y, u_size_x)];
+    const float acc = momentum_f_acc(u, v, pos, u_size_x, v_size_x, alpha, 0.0, h);
+
+    f[INDEX(pos.x, pos.y, u_size_x)] = u_center + dt * acc;
+}
+
+
+//! Computes the convective part of the momentum equation for G, see
+//! `momentum_eq_f_conv`.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v, g: (n + 2) * (m + 3)
+//! - b: (n + 2) * (m + 2)
+//!
+__kernel void momentum_eq_g_conv(
+    __global const float* u,
+    __global const float* v,
+    __global float* g,
+    __global const uchar* b,
+    const float alpha,
+    const float dt,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1) + 1);
+
+    const int b_size_x = get_global_size(0);
+    const int u_size_x = b_size_x + 1;
+    const int v_size_x = b_size_x;
+
+    // only execute on fluid-to-fluid cell boundaries
+    const uchar b_center = b[INDEX(pos.x, pos.y - 1, b_size_x)];
+    if ((b_center & BC_MASK_SELF) != BC_SELF_FLUID || !BC_IS_NEIGHBOR_TOP_FLUID(b_center)) {
+        return;
+    }
+
+    const float v_center = v[INDEX(pos.x, pos.y, v_size_x)];
+    const float acc = momentum_g_acc(u, v, pos, u_size_x, v_size_x, alpha, 0.0, h);
+
+    g[INDEX(pos.x, pos.y, b_size_x)] = v_center + dt * acc;
+}
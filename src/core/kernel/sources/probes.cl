@@ -0,0 +1,54 @@
+//! Kernels for point probes.
+//!
+
+
+//! Converts a two-dimensional index to a linear index.
+#define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
+
+
+//! Bilinearly interpolates a field at the given physical position. The value
+//! at index (i, j) is located at ((i + offs.x) * h.x, (j + offs.y) * h.y).
+float interpolate(__global const float* field, const int2 size, const float2 offs, const float2 pos, const float2 h) {
+    const float2 idx = pos / h - offs;
+
+    const int2 i0 = clamp(convert_int2(floor(idx)), (int2)(0, 0), size - 2);
+    const float2 s = clamp(idx - convert_float2(i0), 0.0f, 1.0f);
+
+    const float f00 = field[INDEX(i0.x,     i0.y,     size.x)];
+    const float f10 = field[INDEX(i0.x + 1, i0.y,     size.x)];
+    const float f01 = field[INDEX(i0.x,     i0.y + 1, size.x)];
+    const float f11 = field[INDEX(i0.x + 1, i0.y + 1, size.x)];
+
+    return mix(mix(f00, f10, s.x), mix(f01, f11, s.x), s.y);
+}
+
+
+//! Samples u, v and p at the probe positions and writes them to the ring
+//! buffer, starting at `offset` (three values per probe).
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - p: (n + 2) * (m + 2), given as `size`
+//!
+__kernel void sample_probes(
+    __global const float* u,
+    __global const float* v,
+    __global const float* p,
+    __global const float2* positions,
+    __global float* ring,
+    const uint offset,
+    const int2 size,
+    const float2 h
+) {
+    const int i = get_global_id(0);
+    const float2 pos = positions[i];
+
+    const float val_u = interpolate(u, size + (int2)(1, 0), (float2)(0.0f, 0.5f), pos, h);
+    const float val_v = interpolate(v, size + (int2)(0, 1), (float2)(0.5f, 0.0f), pos, h);
+    const float val_p = interpolate(p, size, (float2)(0.5f, 0.5f), pos, h);
+
+    ring[offset + 3 * i + 0] = val_u;
+    ring[offset + 3 * i + 1] = val_v;
+    ring[offset + 3 * i + 2] = val_p;
+}
@@ -202,3 +202,109 @@ __kernel void reduce_sum(
         output[get_group_id(0)] = acc;
     }
 }
+
+
+//! Reduces the change between two fields in maximum-norm. Outputs the maximum
+//! absolute difference and the maximum absolute value of `input`, in the same
+//! layout as `reduce_minmax`.
+__kernel void reduce_diff_max_abs(
+    __global const float* input,
+    __global const float* prev,
+    __global float* output,         // size: 2 * #workgroups
+    __local float* shared,          // size: 2 * local-size
+    const uint n
+) {
+    const int global_idx = get_global_id(0);
+    const int global_len = get_global_size(0);
+    const int local_idx = get_local_id(0);
+    const int local_len = get_local_size(0);
+
+    // Initialize accumulator
+    float acc_diff = 0.0;
+    float acc_ref = 0.0;
+
+    // Stage 1: Serial reduction (reduce to global size)
+    for (int i = global_idx; i < n; i += global_len) {
+        acc_diff = fmax(acc_diff, fabs(input[i] - prev[i]));
+        acc_ref = fmax(acc_ref, fabs(input[i]));
+    }
+
+    // Stage 2: Parallel reduction (reduce to #workgroups)
+    shared[local_idx] = acc_diff;
+    shared[local_len + local_idx] = acc_ref;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int offs = (local_len >> 1); offs > 0; offs >>= 1) {
+        if (local_idx < offs) {
+            acc_diff = fmax(acc_diff, shared[local_idx + offs]);
+            acc_ref = fmax(acc_ref, shared[local_len + local_idx + offs]);
+
+            shared[local_idx] = acc_diff;
+            shared[local_len + local_idx] = acc_ref;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // Write-back result
+    if (local_idx == 0) {
+        int group_idx = get_group_id(0);
+        int group_len = get_num_groups(0);
+
+        output[group_idx] = acc_diff;
+        output[group_len + group_idx] = acc_ref;
+    }
+}
+
+
+//! Reduces the change between two fields in (squared) L2-norm. Outputs the
+//! sum of squared differences and the sum of squares of `input`, in the same
+//! layout as `reduce_minmax`.
+__kernel void reduce_diff_sum_sq(
+    __global const float* input,
+    __global const float* prev,
+    __global float* output,         // size: 2 * #workgroups
+    __local float* shared,          // size: 2 * local-size
+    const uint n
+) {
+    const int global_idx = get_global_id(0);
+    const int global_len = get_global_size(0);
+    const int local_idx = get_local_id(0);
+    const int local_len = get_local_size(0);
+
+    // Initialize accumulator
+    float acc_diff = 0.0;
+    float acc_ref = 0.0;
+
+    // Stage 1: Serial reduction (reduce to global size)
+    for (int i = global_idx; i < n; i += global_len) {
+        const float d = input[i] - prev[i];
+
+        acc_diff = acc_diff + d * d;
+        acc_ref = acc_ref + input[i] * input[i];
+    }
+
+    // Stage 2: Parallel reduction (reduce to #workgroups)
+    shared[local_idx] = acc_diff;
+    shared[local_len + local_idx] = acc_ref;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int offs = (local_len >> 1); offs > 0; offs >>= 1) {
+        if (local_idx < offs) {
+            acc_diff = acc_diff + shared[local_idx + offs];
+            acc_ref = acc_ref + shared[local_len + local_idx + offs];
+
+            shared[local_idx] = acc_diff;
+            shared[local_len + local_idx] = acc_ref;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // Write-back result
+    if (local_idx == 0) {
+        int group_idx = get_group_id(0);
+        int group_len = get_num_groups(0);
+
+        output[group_idx] = acc_diff;
+        output[group_len + group_idx] = acc_ref;
+    }
+}
@@ -9,6 +9,7 @@ namespace resources {
 
 extern const utils::Resource boundaries_cl;
 extern const utils::Resource momentum_cl;
+extern const utils::Resource diffusion_cl;
 extern const utils::Resource rhs_cl;
 extern const utils::Resource velocities_cl;
 extern const utils::Resource solver_cl;
@@ -17,7 +18,12 @@ extern const utils::Resource visualize_cl;
 
 extern const utils::Resource reduce_cl;
 extern const utils::Resource zero_cl;
+extern const utils::Resource arith_cl;
+extern const utils::Resource statistics_cl;
+extern const utils::Resource probes_cl;
+extern const utils::Resource forces_cl;
 extern const utils::Resource copy_cl;
+extern const utils::Resource geometry_cl;
 
 }   /* namespace resources */
 }   /* namespace kernel */
@@ -0,0 +1,78 @@
+//! Kernels for time-averaged flow statistics.
+//!
+
+
+#define BC_MASK_SELF                    0b00001111
+#define BC_SELF_FLUID                   0b0000
+
+
+//! Converts a two-dimensional index to a linear index.
+#define INDEX(x, y, size_x) (((y) * (size_x)) + (x))
+
+
+//! Statistics planes, each of size (n + 2) * (m + 2).
+#define STATS_MEAN_U    0
+#define STATS_MEAN_V    1
+#define STATS_MEAN_P    2
+#define STATS_M2_UU     3
+#define STATS_M2_VV     4
+#define STATS_C_UV      5
+
+
+//! Adds the current state as new sample to the running statistics using
+//! Welford's algorithm. Velocities are interpolated to the cell centers.
+//! The second moments are accumulated as sums of squared deviations, i.e.
+//! they have to be divided by the number of samples to obtain the
+//! (co-)variances.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - p, b: (n + 2) * (m + 2)
+//! - stats: 6 * (n + 2) * (m + 2), see STATS_* for planes
+//!
+__kernel void accumulate_statistics(
+    __global const float* u,
+    __global const float* v,
+    __global const float* p,
+    __global const uchar* b,
+    __global float* stats,
+    const float inv_n               // 1 / (number of samples including this one)
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+
+    const int p_size_x = get_global_size(0);
+    const int u_size_x = p_size_x + 1;
+    const int v_size_x = p_size_x;
+    const int plane = p_size_x * get_global_size(1);
+
+    const int idx = INDEX(pos.x, pos.y, p_size_x);
+
+    if ((b[idx] & BC_MASK_SELF) != BC_SELF_FLUID) {
+        return;
+    }
+
+    // current sample
+    const float u_c = (u[INDEX(pos.x, pos.y, u_size_x)] + u[INDEX(pos.x + 1, pos.y, u_size_x)]) / 2.0;
+    const float v_c = (v[INDEX(pos.x, pos.y, v_size_x)] + v[INDEX(pos.x, pos.y + 1, v_size_x)]) / 2.0;
+    const float p_c = p[idx];
+
+    // Welford update
+    const float mean_u = stats[STATS_MEAN_U * plane + idx];
+    const float mean_v = stats[STATS_MEAN_V * plane + idx];
+    const float mean_p = stats[STATS_MEAN_P * plane + idx];
+
+    const float du = u_c - mean_u;
+    const float dv = v_c - mean_v;
+
+    const float mean_u_new = mean_u + du * inv_n;
+    const float mean_v_new = mean_v + dv * inv_n;
+
+    stats[STATS_MEAN_U * plane + idx] = mean_u_new;
+    stats[STATS_MEAN_V * plane + idx] = mean_v_new;
+    stats[STATS_MEAN_P * plane + idx] = mean_p + (p_c - mean_p) * inv_n;
+
+    stats[STATS_M2_UU * plane + idx] += du * (u_c - mean_u_new);
+    stats[STATS_M2_VV * plane + idx] += dv * (v_c - mean_v_new);
+    stats[STATS_C_UV * plane + idx] += du * (v_c - mean_v_new);
+}
@@ -72,3 +72,54 @@ __kernel void new_velocities(
         v[INDEX(pos.x, pos.y + 1, v_size_x)] = g_center - dt * p_dy_r;
     }
 }
+
+
+//! Computes the local pseudo-time step for a cell, see `momentum.cl`.
+float local_dt(const float u_abs, const float v_abs, const float re, const float tau, const float dt_max, const float2 h) {
+    const float dt_diff = ((h.x * h.x * h.y * h.y) / (h.x * h.x + h.y * h.y)) * re * 0.5;
+    const float dt_conv = fmin(h.x / fmax(u_abs, 1e-6f), h.y / fmax(v_abs, 1e-6f));
+
+    return fmin(dt_max, tau * fmin(dt_diff, dt_conv));
+}
+
+
+//! Accumulates the pressure increment of a local time-stepping projection.
+//!
+//! The projection is performed with unit time step, thus the increment `phi`
+//! is scaled by the inverse local time step of the cell, computed from the
+//! cell-centered velocities.
+//!
+//! Grid sizes:
+//! - u: (n + 3) * (m + 2)
+//! - v: (n + 2) * (m + 3)
+//! - p, phi, b: (n + 2) * (m + 2)
+//!
+__kernel void accumulate_pressure(
+    __global float* p,
+    __global const float* phi,
+    __global const float* u,
+    __global const float* v,
+    __global const uchar* b,
+    const float re,
+    const float tau,
+    const float dt_max,
+    const float2 h
+) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+
+    const int p_size_x = get_global_size(0);
+    const int u_size_x = p_size_x + 1;
+    const int v_size_x = p_size_x;
+
+    // only update fluid cells, boundaries are set separately
+    if ((b[INDEX(pos.x, pos.y, p_size_x)] & BC_MASK_SELF) != BC_SELF_FLUID) {
+        return;
+    }
+
+    const float u_center = (u[INDEX(pos.x, pos.y, u_size_x)] + u[INDEX(pos.x + 1, pos.y, u_size_x)]) / 2.0;
+    const float v_center = (v[INDEX(pos.x, pos.y, v_size_x)] + v[INDEX(pos.x, pos.y + 1, v_size_x)]) / 2.0;
+
+    const float dt = local_dt(fabs(u_center), fabs(v_center), re, tau, dt_max, h);
+
+    p[INDEX(pos.x, pos.y, p_size_x)] += phi[INDEX(pos.x, pos.y, p_size_x)] / dt;
+}
@@ -0,0 +1,149 @@
+#include "core/metrics.hpp"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+namespace core {
+namespace {
+
+auto file_size(std::string const& file) -> std::uint64_t {
+    std::ifstream in{file, std::ios::binary | std::ios::ate};
+    if (!in) {
+        return 0;
+    }
+
+    auto const size = in.tellg();
+    return size > 0 ? static_cast<std::uint64_t>(size) : 0;
+}
+
+auto escape_label(std::string const& str) -> std::string {
+    std::string out;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        } else if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+void write_metric(std::ostream& out, char const* name, char const* type, char const* help, double value) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+    out << name << " " << value << "\n";
+}
+
+}   /* namespace */
+
+
+MetricsWriter::MetricsWriter(char const* file, double interval)
+    : m_file{file ? file : ""}
+    , m_enabled{file != nullptr}
+    , m_interval{interval}
+    , m_device{}
+    , m_scenario{}
+    , m_outputs{}
+    , m_last_time{Clock::now()}
+    , m_last_attempt{m_last_time}
+    , m_last_steps{0}
+    , m_last_sor_iterations{0} {}
+
+void MetricsWriter::set_info(std::string const& device, std::string const& scenario) {
+    m_device = device;
+    m_scenario = scenario;
+}
+
+void MetricsWriter::add_output(std::string const& file) {
+    if (!m_enabled) {
+        return;
+    }
+
+    m_outputs.push_back(file);
+}
+
+auto MetricsWriter::due() const -> bool {
+    return m_enabled && std::chrono::duration<double>(Clock::now() - m_last_attempt).count() >= m_interval;
+}
+
+void MetricsWriter::write(Metrics const& m) {
+    if (!m_enabled) {
+        return;
+    }
+
+    auto const now = Clock::now();
+    m_last_attempt = now;
+
+    double const elapsed = std::chrono::duration<double>(now - m_last_time).count();
+
+    uint_t const steps = m.steps - m_last_steps;
+    std::uint64_t const sor_iterations = m.sor_iterations - m_last_sor_iterations;
+
+    double const steps_per_second = elapsed > 0.0 ? steps / elapsed : 0.0;
+    double const sor_avg = steps > 0 ? static_cast<double>(sor_iterations) / steps : 0.0;
+
+    std::uint64_t bytes_written = 0;
+    for (auto const& file : m_outputs) {
+        bytes_written += file_size(file);
+    }
+
+    // write to temporary file first, scrapers never see partial files
+    auto const tmp = m_file + ".tmp";
+
+    {
+        std::ofstream out{tmp, std::ios::trunc};
+        if (!out) {
+            std::cout << "WARNING: failed to open metrics file `" << tmp << "`, retrying at the next update\n";
+            return;
+        }
+
+        out << std::setprecision(12);
+
+        out << "# HELP numsim_info Run information.\n";
+        out << "# TYPE numsim_info gauge\n";
+        out << "numsim_info{device=\"" << escape_label(m_device) << "\",scenario=\"" << escape_label(m_scenario)
+            << "\"} 1\n";
+
+        write_metric(out, "numsim_steps_total", "counter", "Time steps completed.", m.steps);
+        write_metric(out, "numsim_simulated_time", "gauge", "Simulated time.", m.time);
+        write_metric(out, "numsim_steps_per_second", "gauge", "Time steps per second over the last interval.",
+                     steps_per_second);
+        write_metric(out, "numsim_sor_iterations_total", "counter", "SOR iterations over all steps.",
+                     static_cast<double>(m.sor_iterations));
+        write_metric(out, "numsim_sor_iterations_avg", "gauge", "SOR iterations per step over the last interval.",
+                     sor_avg);
+        write_metric(out, "numsim_residual", "gauge", "Final SOR residual of the last step.", m.residual);
+        write_metric(out, "numsim_device_memory_bytes", "gauge", "Allocated device buffers.",
+                     static_cast<double>(m.device_memory));
+        write_metric(out, "numsim_output_bytes", "gauge", "Bytes written to output files (current size).",
+                     static_cast<double>(bytes_written));
+        write_metric(out, "numsim_last_update_timestamp_seconds", "gauge", "Unix time of the last update.",
+                     static_cast<double>(std::time(nullptr)));
+
+        out.close();
+
+        if (!out) {
+            std::cout << "WARNING: failed to write metrics file `" << tmp << "`, retrying at the next update\n";
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), m_file.c_str()) != 0) {
+        std::cout << "WARNING: failed to replace metrics file `" << m_file << "`, retrying at the next update\n";
+        std::remove(tmp.c_str());
+        return;
+    }
+
+    m_last_time = now;
+    m_last_steps = m.steps;
+    m_last_sor_iterations = m.sor_iterations;
+}
+
+}   /* namespace core */
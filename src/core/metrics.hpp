@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace core {
+
+//! Current state of the run, as exported by the `MetricsWriter`.
+struct Metrics {
+    uint_t steps;
+    real_t time;                        //!< simulated time
+    std::uint64_t sor_iterations;       //!< total over all steps
+    real_t residual;                    //!< final residual of the last step
+    std::size_t device_memory;          //!< allocated device buffers in bytes
+};
+
+
+//! Periodically writes metrics in the Prometheus text exposition format, e.g.
+//! for the textfile collector of the node exporter.
+//!
+//! The file is replaced atomically (written to a temporary file first), so
+//! that scrapers never see partial files. Besides the given metrics, rates
+//! over the last interval, the total size of all registered output files and
+//! the time of the last update are exported.
+//!
+//! Write failures (e.g. a full disk) are not fatal: a warning is printed, the
+//! previous file is kept and the write is retried after the next interval.
+//!
+//! If no output file is given, the writer is disabled and all calls are no-ops.
+class MetricsWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    MetricsWriter(char const* file, double interval);
+
+    inline auto enabled() const -> bool;
+
+    //! Adds labels to the `numsim_info` metric.
+    void set_info(std::string const& device, std::string const& scenario);
+
+    //! Registers an output file, accounted for in the bytes written. Ignored
+    //! if disabled, thus files can be registered as they are written.
+    void add_output(std::string const& file);
+
+    //! Whether the update interval has passed since the last write.
+    auto due() const -> bool;
+
+    void write(Metrics const& metrics);
+
+private:
+    std::string m_file;
+    bool m_enabled;
+    double m_interval;
+
+    std::string m_device;
+    std::string m_scenario;
+    std::vector<std::string> m_outputs;
+
+    Clock::time_point m_last_time;      // of the last successful write, base of the rates
+    Clock::time_point m_last_attempt;
+    uint_t m_last_steps;
+    std::uint64_t m_last_sor_iterations;
+};
+
+
+auto MetricsWriter::enabled() const -> bool {
+    return m_enabled;
+}
+
+}   /* namespace core */
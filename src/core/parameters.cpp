@@ -1,14 +1,16 @@
 #include "core/parameters.hpp"
 #include "utils/trim.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
 
 
 namespace core {
 
-void Parameters::load(char const* file) {
+void Parameters::load(char const* file, std::ostream& log) {
     std::ifstream in;
     in.open(file);
 
@@ -37,10 +39,85 @@ void Parameters::load(char const* file) {
             tokenstr >> eps;
         } else if (key == "tau") {
             tokenstr >> tau;
+        } else if (key == "timestepping") {
+            std::string mode;
+            tokenstr >> mode;
+
+            if (mode == "global") {
+                timestepping = TimeStepping::Global;
+            } else if (mode == "local") {
+                timestepping = TimeStepping::Local;
+            } else {
+                std::stringstream msg;
+                msg << "Invalid timestepping `" << mode << "` in file `" << file << "`";
+                throw std::invalid_argument(msg.str());
+            }
+        } else if (key == "integrator") {
+            std::string name;
+            tokenstr >> name;
+
+            if (name == "euler") {
+                integrator = Integrator::Euler;
+            } else if (name == "rk2") {
+                integrator = Integrator::Rk2;
+            } else if (name == "rk3") {
+                integrator = Integrator::Rk3;
+            } else {
+                std::stringstream msg;
+                msg << "Invalid integrator `" << name << "` in file `" << file << "`";
+                throw std::invalid_argument(msg.str());
+            }
+        } else if (key == "implicit_diffusion") {
+            tokenstr >> implicit_diffusion;
+        } else if (key == "diff_iter") {
+            tokenstr >> diff_iter;
+        } else if (key == "steady_eps") {
+            tokenstr >> steady_eps;
+        } else if (key == "steady_interval") {
+            tokenstr >> steady_interval;
+        } else if (key == "steady_window") {
+            tokenstr >> steady_window;
+        } else if (key == "steady_norm") {
+            std::string norm;
+            tokenstr >> norm;
+
+            if (norm == "max") {
+                steady_norm = SteadyNorm::Max;
+            } else if (norm == "l2") {
+                steady_norm = SteadyNorm::L2;
+            } else {
+                std::stringstream msg;
+                msg << "Invalid steady_norm `" << norm << "` in file `" << file << "`";
+                throw std::invalid_argument(msg.str());
+            }
+        } else if (key == "steady_exit") {
+            tokenstr >> steady_exit;
+        } else if (key == "stats") {
+            tokenstr >> stats;
+        } else if (key == "stats_start") {
+            tokenstr >> stats_start;
+        } else if (key == "stats_interval") {
+            tokenstr >> stats_interval;
+        } else if (key == "stats_checkpoint") {
+            tokenstr >> stats_checkpoint;
+        } else if (key == "stats_file") {
+            tokenstr >> stats_file;
+        } else if (key == "forces") {
+            tokenstr >> forces;
+        } else if (key == "forces_file") {
+            tokenstr >> forces_file;
+        } else if (key == "force_ref_velocity") {
+            tokenstr >> force_ref_velocity;
+        } else if (key == "force_ref_length") {
+            tokenstr >> force_ref_length;
         } else {
-            std::cout << "WARNING: unknown key `" << key << "` in file `" << file << "`\n";
+            log << "WARNING: unknown key `" << key << "` in file `" << file << "`\n";
         }
     }
+
+    steady_interval = std::max<uint_t>(steady_interval, 1);
+    steady_window = std::max<uint_t>(steady_window, 1);
+    stats_interval = std::max<uint_t>(stats_interval, 1);
 }
 
 }   /* namespace core */
@@ -2,9 +2,31 @@
 
 #include "types.hpp"
 
+#include <iostream>
+#include <string>
+
 
 namespace core {
 
+//! Norm used to measure the change of the velocity field between steps.
+enum class SteadyNorm {
+    Max,
+    L2,
+};
+
+//! Time-stepping mode.
+enum class TimeStepping {
+    Global,         //!< time-accurate, uniform time step
+    Local,          //!< pseudo-time, per-cell time step (steady-state only)
+};
+
+//! Explicit time integration scheme.
+enum class Integrator {
+    Euler,
+    Rk2,            //!< strong-stability-preserving Runge-Kutta, 2nd order
+    Rk3,            //!< strong-stability-preserving Runge-Kutta, 3rd order
+};
+
 //! Simulation parameters.
 struct Parameters {
     real_t re       = 1000.0;
@@ -16,8 +38,36 @@ struct Parameters {
     real_t tau      = 0.5;
     int_t  itermax  = 100;
 
-    //! Load parameters from file.
-    void load(char const* file);
+    TimeStepping timestepping = TimeStepping::Global;
+    Integrator   integrator   = Integrator::Euler;
+
+    // implicit treatment of the viscous term (global time-stepping only)
+    bool   implicit_diffusion   = false;
+    int_t  diff_iter            = 10;
+
+    // steady-state detection, disabled if steady_eps <= 0
+    real_t     steady_eps       = 0.0;
+    uint_t     steady_interval  = 10;
+    uint_t     steady_window    = 3;
+    SteadyNorm steady_norm      = SteadyNorm::Max;
+    bool       steady_exit      = false;
+
+    // time-averaged statistics, accumulated every stats_interval steps after
+    // stats_start, written at exit and every stats_checkpoint samples (if > 0)
+    bool        stats               = false;
+    real_t      stats_start         = 0.0;
+    uint_t      stats_interval      = 1;
+    uint_t      stats_checkpoint    = 0;
+    std::string stats_file          = "statistics.field";
+
+    // obstacle forces (drag/lift), coefficients use 2 F / (u_ref^2 * l_ref)
+    bool        forces              = false;
+    std::string forces_file         = "forces.csv";
+    real_t      force_ref_velocity  = 1.0;
+    real_t      force_ref_length    = 1.0;
+
+    //! Load parameters from file, warnings about unknown keys are written to `log`.
+    void load(char const* file, std::ostream& log = std::cout);
 };
 
 }   /* namespace core */
@@ -0,0 +1,144 @@
+#include "core/perf_counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+
+namespace core {
+
+#ifdef __linux__
+
+namespace {
+
+const std::uint64_t PERF_EVENT_CONFIG[NUM_PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,         // usually last-level cache misses
+};
+
+auto perf_event_open(perf_event_attr* attr, pid_t tid) -> int {
+    return static_cast<int>(syscall(__NR_perf_event_open, attr, tid, -1, -1, 0));
+}
+
+auto process_threads() -> std::vector<pid_t> {
+    std::vector<pid_t> tids;
+
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) {
+        return tids;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+        }
+    }
+
+    closedir(dir);
+    return tids;
+}
+
+}   /* namespace */
+
+
+PerfCounters::PerfCounters()
+    : m_fds{}
+    , m_available{true}
+{
+    auto const tids = process_threads();
+    if (tids.empty()) {
+        m_available = false;
+        return;
+    }
+
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS && m_available; i++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_EVENT_CONFIG[i];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 1;                   // later threads: only counted once they have exited
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        for (auto tid : tids) {
+            int const fd = perf_event_open(&attr, tid);
+
+            // threads may have exited in the meantime, any other error disables the counters
+            if (fd < 0) {
+                if (errno == ESRCH) {
+                    continue;
+                }
+
+                m_available = false;
+                break;
+            }
+
+            m_fds[i].push_back(fd);
+        }
+    }
+
+    if (!m_available) {
+        for (auto& fds : m_fds) {
+            for (int fd : fds) {
+                close(fd);
+            }
+            fds.clear();
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (auto const& fds : m_fds) {
+        for (int fd : fds) {
+            close(fd);
+        }
+    }
+}
+
+auto PerfCounters::read() const -> PerfSample {
+    PerfSample sample{};
+
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; i++) {
+        for (int fd : m_fds[i]) {
+            std::uint64_t data[3] = {};     // value, time enabled, time running
+            if (::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                continue;
+            }
+
+            // scale to compensate for multiplexing of the hardware counters
+            if (data[2] > 0 && data[2] < data[1]) {
+                data[0] = static_cast<std::uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+            }
+
+            sample.values[i] += data[0];
+        }
+    }
+
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+    : m_fds{}
+    , m_available{false} {}
+
+PerfCounters::~PerfCounters() {}
+
+auto PerfCounters::read() const -> PerfSample {
+    return PerfSample{};
+}
+
+#endif
+
+}   /* namespace core */
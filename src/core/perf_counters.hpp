@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+namespace core {
+
+//! Hardware events counted by `PerfCounters`.
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    LlcMisses,
+};
+
+const std::size_t NUM_PERF_EVENTS = 3;
+
+inline auto perf_event_to_string(PerfEvent event) -> char const*;
+
+
+//! Counter values, indexed by `PerfEvent`.
+struct PerfSample {
+    std::array<std::uint64_t, NUM_PERF_EVENTS> values;
+
+    inline auto operator[] (PerfEvent event) const -> std::uint64_t;
+};
+
+inline auto operator+ (PerfSample const& a, PerfSample const& b) -> PerfSample;
+inline auto operator- (PerfSample const& a, PerfSample const& b) -> PerfSample;
+
+
+//! Hardware performance counters of the whole process via `perf_event_open`
+//! (Linux only).
+//!
+//! Counters are opened for every thread existing at construction (listed in
+//! `/proc/self/task`) and summed when read. This includes the worker threads
+//! of CPU OpenCL runtimes, thus the counters should be created after the
+//! OpenCL context. Threads created later inherit the counters, but their
+//! counts are only added to the parent's once they exit, i.e. `read()` does
+//! not include threads started after construction that are still running.
+//! Values are scaled to compensate for multiplexing.
+//!
+//! If counters are not supported (other platforms, missing permissions, see
+//! `/proc/sys/kernel/perf_event_paranoid`), `available()` returns false and
+//! `read()` returns zeros.
+class PerfCounters {
+public:
+    PerfCounters();
+    PerfCounters(PerfCounters const&) = delete;
+    ~PerfCounters();
+
+    auto operator= (PerfCounters const&) -> PerfCounters& = delete;
+
+    inline auto available() const -> bool;
+
+    auto read() const -> PerfSample;
+
+private:
+    std::array<std::vector<int>, NUM_PERF_EVENTS> m_fds;
+    bool m_available;
+};
+
+
+auto perf_event_to_string(PerfEvent event) -> char const* {
+    switch (event) {
+    case PerfEvent::Cycles:         return "cycles";
+    case PerfEvent::Instructions:   return "instructions";
+    case PerfEvent::LlcMisses:      return "llc_misses";
+    }
+
+    return "unknown";
+}
+
+auto PerfSample::operator[] (PerfEvent event) const -> std::uint64_t {
+    return values[static_cast<std::size_t>(event)];
+}
+
+auto operator+ (PerfSample const& a, PerfSample const& b) -> PerfSample {
+    PerfSample r;
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; i++) {
+        r.values[i] = a.values[i] + b.values[i];
+    }
+    return r;
+}
+
+auto operator- (PerfSample const& a, PerfSample const& b) -> PerfSample {
+    PerfSample r;
+    for (std::size_t i = 0; i < NUM_PERF_EVENTS; i++) {
+        r.values[i] = a.values[i] - b.values[i];
+    }
+    return r;
+}
+
+
+auto PerfCounters::available() const -> bool {
+    return m_available;
+}
+
+}   /* namespace core */
@@ -0,0 +1,213 @@
+#include "core/probes.hpp"
+#include "utils/trim.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+//! Number of values per probe and sample: u, v, p.
+const uint_t PROBE_VALUES = 3;
+
+}   /* namespace */
+
+
+void ProbeSet::load(char const* file, std::ostream& log) {
+    std::ifstream in;
+    in.open(file);
+
+    if (!in) {
+        std::stringstream msg;
+        msg << "Failed to open probe file `" << file << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    while (in) {
+        std::string line;
+        if (!std::getline(in, line)) { break; }
+
+        line = line.substr(0, line.find('#'));
+
+        std::stringstream tokenstr{line};
+        std::string key;
+        if (!std::getline(tokenstr, key, '=')) { continue; };
+        key = utils::trim(key);
+
+        if (key.empty()) {
+            continue;
+
+        } else if (key == "output") {
+            tokenstr >> output;
+
+        } else if (key == "batch") {
+            tokenstr >> batch;
+
+        } else if (key == "point") {
+            rvec2 pos;
+            std::string name;
+            tokenstr >> pos.x >> pos.y >> name;
+
+            if (name.empty()) {
+                name = "p" + std::to_string(points.size());
+            }
+
+            points.push_back(pos);
+            names.push_back(name);
+
+        } else if (key == "line") {
+            rvec2 a;
+            rvec2 b;
+            uint_t n = 0;
+            std::string name;
+            tokenstr >> a.x >> a.y >> b.x >> b.y >> n >> name;
+
+            if (n == 0) {
+                std::stringstream msg;
+                msg << "Invalid line probe in file `" << file << "`: need at least one sample";
+                throw std::invalid_argument(msg.str());
+            }
+
+            if (name.empty()) {
+                name = "l" + std::to_string(points.size());
+            }
+
+            for (uint_t i = 0; i < n; i++) {
+                real_t const s = n > 1 ? static_cast<real_t>(i) / (n - 1) : 0.0;
+
+                points.push_back({a.x + s * (b.x - a.x), a.y + s * (b.y - a.y)});
+                names.push_back(name + "_" + std::to_string(i));
+            }
+
+        } else {
+            log << "WARNING: unknown key `" << key << "` in file `" << file << "`\n";
+        }
+    }
+
+    batch = std::max<uint_t>(batch, 1);
+}
+
+
+ProbeRecorder::ProbeRecorder(cl::Context const& context, cl::Program const& program, ProbeSet probes)
+    : m_probes{std::move(probes)}
+    , m_out{m_probes.output, std::ios::trunc}
+    , m_kernel{program, "sample_probes"}
+    , m_slot{0}
+    , m_pending{-1}
+{
+    if (m_probes.points.empty()) {
+        throw std::invalid_argument{"Probe set must contain at least one probe"};
+    }
+
+    if (!m_out) {
+        std::stringstream msg;
+        msg << "Failed to open probe output `" << m_probes.output << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    auto positions = std::vector<cl_float2>{};
+    for (auto const& pt : m_probes.points) {
+        positions.push_back({{ static_cast<cl_float>(pt.x), static_cast<cl_float>(pt.y) }});
+    }
+
+    auto const n = m_probes.points.size();
+    m_positions = cl::Buffer{context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, n * sizeof(cl_float2), positions.data()};
+    m_ring = cl::Buffer{context, CL_MEM_READ_WRITE, 2 * m_probes.batch * n * PROBE_VALUES * sizeof(cl_float)};
+
+    for (auto& host : m_host) {
+        host.resize(m_probes.batch * n * PROBE_VALUES);
+    }
+
+    // header
+    m_out << "t";
+    for (auto const& name : m_probes.names) {
+        m_out << "," << name << "_u," << name << "_v," << name << "_p";
+    }
+    m_out << "\n";
+}
+
+void ProbeRecorder::record(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& u,
+                           cl::Buffer const& v, cl::Buffer const& p, ivec2 size, rvec2 mesh, real_t t)
+{
+    auto const n = static_cast<cl_uint>(m_probes.points.size());
+    auto const half = m_slot / m_probes.batch;
+
+    cl_int2 size_cl = {{ size.x, size.y }};
+    cl_float2 h = {{ static_cast<cl_float>(mesh.x), static_cast<cl_float>(mesh.y) }};
+
+    m_kernel.setArg(0, u);
+    m_kernel.setArg(1, v);
+    m_kernel.setArg(2, p);
+    m_kernel.setArg(3, m_positions);
+    m_kernel.setArg(4, m_ring);
+    m_kernel.setArg(5, static_cast<cl_uint>(m_slot * n * PROBE_VALUES));
+    m_kernel.setArg(6, size_cl);
+    m_kernel.setArg(7, h);
+
+    tracer.enqueue(queue, m_kernel, cl::NDRange(n), cl::NullRange);
+
+    m_times[half].push_back(t);
+    m_slot = (m_slot + 1) % (2 * m_probes.batch);
+
+    // half full: write previous read-back, start asynchronous read-back of this half
+    if (m_slot % m_probes.batch == 0) {
+        write_pending();
+
+        auto const bytes = m_host[half].size() * sizeof(cl_float);
+        queue.enqueueReadBuffer(m_ring, CL_FALSE, half * bytes, bytes, m_host[half].data(), nullptr, &m_pending_event);
+        m_pending = static_cast<int>(half);
+    }
+}
+
+void ProbeRecorder::flush(cl::CommandQueue const& queue) {
+    write_pending();
+
+    // partially filled half
+    auto const half = m_slot / m_probes.batch;
+    auto const count = m_slot % m_probes.batch;
+
+    if (count > 0) {
+        auto const n = m_probes.points.size();
+        auto const bytes = m_host[half].size() * sizeof(cl_float);
+
+        queue.enqueueReadBuffer(m_ring, CL_TRUE, half * bytes, count * n * PROBE_VALUES * sizeof(cl_float),
+                                m_host[half].data());
+
+        write_rows(m_host[half], m_times[half]);
+        m_times[half].clear();
+        m_slot = ((half + 1) % 2) * m_probes.batch;
+    }
+
+    m_out.flush();
+}
+
+void ProbeRecorder::write_pending() {
+    if (m_pending < 0) {
+        return;
+    }
+
+    m_pending_event.wait();
+
+    write_rows(m_host[m_pending], m_times[m_pending]);
+    m_times[m_pending].clear();
+    m_pending = -1;
+}
+
+void ProbeRecorder::write_rows(std::vector<cl_float> const& data, std::vector<real_t> const& times) {
+    auto const stride = m_probes.points.size() * PROBE_VALUES;
+
+    for (std::size_t row = 0; row < times.size(); row++) {
+        m_out << times[row];
+
+        for (std::size_t i = 0; i < stride; i++) {
+            m_out << "," << data[row * stride + i];
+        }
+
+        m_out << "\n";
+    }
+}
+
+}   /* namespace core */
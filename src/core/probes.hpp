@@ -0,0 +1,71 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/trace.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace core {
+
+//! Set of probe locations (in physical coordinates) to be recorded over time.
+//!
+//! Loaded from a `key = value` file:
+//!
+//!   output = probes.csv                       # output file (CSV)
+//!   batch  = 256                              # samples per device read-back
+//!   point  = <x> <y> [name]                   # single probe
+//!   line   = <x0> <y0> <x1> <y1> <n> [name]   # n equidistant probes
+//!
+struct ProbeSet {
+    std::vector<rvec2> points;
+    std::vector<std::string> names;
+
+    std::string output = "probes.csv";
+    uint_t batch = 256;
+
+    //! Load probes from file, warnings about unknown keys are written to `log`.
+    void load(char const* file, std::ostream& log = std::cout);
+};
+
+
+//! Records interpolated `u`, `v` and `p` at the probe locations into a device
+//! ring buffer of two halves. Full halves are read back asynchronously while
+//! the other half is being filled, and written to the CSV output.
+class ProbeRecorder {
+public:
+    ProbeRecorder(cl::Context const& context, cl::Program const& program, ProbeSet probes);
+
+    //! Enqueues sampling of the current state at simulation time `t` via the tracer.
+    void record(Tracer& tracer, cl::CommandQueue const& queue, cl::Buffer const& u, cl::Buffer const& v,
+                cl::Buffer const& p, ivec2 size, rvec2 mesh, real_t t);
+
+    //! Writes all recorded samples, blocks until done.
+    void flush(cl::CommandQueue const& queue);
+
+private:
+    void write_pending();
+    void write_rows(std::vector<cl_float> const& data, std::vector<real_t> const& times);
+
+private:
+    ProbeSet m_probes;
+    std::ofstream m_out;
+
+    cl::Kernel m_kernel;
+    cl::Buffer m_positions;
+    cl::Buffer m_ring;
+
+    uint_t m_slot;                              // next slot in the ring buffer
+    std::vector<real_t> m_times[2];             // times of the samples per half
+    std::vector<cl_float> m_host[2];            // read-back buffers per half
+
+    int m_pending;                              // half with read-back in flight, or -1
+    cl::Event m_pending_event;
+};
+
+}   /* namespace core */
@@ -0,0 +1,138 @@
+#include "core/prolongation.hpp"
+
+#include "core/geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+//! Staggered field: size relative to the cell grid, the value at index (i, j)
+//! is located at ((i + offs.x) * h.x, (j + offs.y) * h.y).
+struct Staggered {
+    char const* name;
+    ivec2 extra;
+    rvec2 offs;
+};
+
+//! Grid of cell types with clamped access.
+class CellMask {
+public:
+    CellMask(ivec2 size, rvec2 h, std::vector<std::uint8_t> const& boundary)
+        : m_size{size}, m_h{h}, m_boundary{boundary} {}
+
+    //! Whether the cell containing the physical position is fluid.
+    inline auto is_fluid(real_t x, real_t y) const -> bool {
+        auto const i = std::min(std::max(static_cast<int_t>(std::floor(x / m_h.x)), 0), m_size.x - 1);
+        auto const j = std::min(std::max(static_cast<int_t>(std::floor(y / m_h.y)), 0), m_size.y - 1);
+
+        return (m_boundary[static_cast<std::size_t>(j) * m_size.x + i] & CELL_MASK_SELF) == 0;
+    }
+
+private:
+    ivec2 m_size;
+    rvec2 m_h;
+    std::vector<std::uint8_t> const& m_boundary;
+};
+
+auto prolongate_field(Field const& coarse, rvec2 h_coarse, ivec2 size, rvec2 h, Staggered const& stag,
+                      CellMask const& mask) -> Field
+{
+    auto const nx = static_cast<uint_t>(size.x + stag.extra.x);
+    auto const ny = static_cast<uint_t>(size.y + stag.extra.y);
+    auto const cx = static_cast<int_t>(coarse.size.x);
+    auto const cy = static_cast<int_t>(coarse.size.y);
+
+    auto field = Field{coarse.name, {nx, ny}, std::vector<float>(static_cast<std::size_t>(nx) * ny, 0.0f)};
+
+    for (uint_t j = 0; j < ny; j++) {
+        for (uint_t i = 0; i < nx; i++) {
+            real_t const x = (i + stag.offs.x) * h.x;
+            real_t const y = (j + stag.offs.y) * h.y;
+
+            // obstacles: set by the boundary conditions where required
+            if (!mask.is_fluid(x, y)) {
+                continue;
+            }
+
+            real_t const ix = x / h_coarse.x - stag.offs.x;
+            real_t const iy = y / h_coarse.y - stag.offs.y;
+
+            int_t const i0 = std::min(std::max(static_cast<int_t>(std::floor(ix)), 0), cx - 2);
+            int_t const j0 = std::min(std::max(static_cast<int_t>(std::floor(iy)), 0), cy - 2);
+
+            real_t const sx = std::min(std::max(ix - i0, 0.0f), 1.0f);
+            real_t const sy = std::min(std::max(iy - j0, 0.0f), 1.0f);
+
+            // bilinear weights, restricted to coarse samples in fluid cells of the fine grid
+            real_t value = 0.0;
+            real_t value_all = 0.0;
+            real_t weight = 0.0;
+
+            for (int_t dj = 0; dj < 2; dj++) {
+                for (int_t di = 0; di < 2; di++) {
+                    real_t const w = (di ? sx : 1.0f - sx) * (dj ? sy : 1.0f - sy);
+                    real_t const f = coarse.data[static_cast<std::size_t>(j0 + dj) * cx + (i0 + di)];
+
+                    value_all += w * f;
+
+                    real_t const sample_x = (i0 + di + stag.offs.x) * h_coarse.x;
+                    real_t const sample_y = (j0 + dj + stag.offs.y) * h_coarse.y;
+
+                    if (mask.is_fluid(sample_x, sample_y)) {
+                        value += w * f;
+                        weight += w;
+                    }
+                }
+            }
+
+            // no fluid sample nearby (e.g. thin channels below the coarse resolution): plain interpolation
+            field.data[static_cast<std::size_t>(j) * nx + i] = weight > 1e-6f ? value / weight : value_all;
+        }
+    }
+
+    return field;
+}
+
+}   /* namespace */
+
+
+auto prolongate(FieldSet const& coarse, ivec2 size, std::vector<std::uint8_t> const& boundary) -> FieldSet {
+    if (boundary.size() != static_cast<std::size_t>(size.x) * size.y) {
+        throw std::invalid_argument("Boundary size does not match grid size");
+    }
+
+    auto const h_coarse = rvec2{coarse.length.x / coarse.size.x, coarse.length.y / coarse.size.y};
+    auto const h = rvec2{coarse.length.x / size.x, coarse.length.y / size.y};
+
+    auto const mask = CellMask{size, h, boundary};
+
+    FieldSet fine{size, coarse.length, coarse.time, {}};
+
+    for (auto const& stag : {
+        Staggered{"u", {1, 0}, {0.0, 0.5}},
+        Staggered{"v", {0, 1}, {0.5, 0.0}},
+        Staggered{"p", {0, 0}, {0.5, 0.5}},
+    }) {
+        auto const* field = coarse.find(stag.name);
+        auto const cx = static_cast<int_t>(coarse.size.x + stag.extra.x);
+        auto const cy = static_cast<int_t>(coarse.size.y + stag.extra.y);
+
+        if (!field || static_cast<int_t>(field->size.x) != cx || static_cast<int_t>(field->size.y) != cy
+                || cx < 2 || cy < 2) {
+            std::stringstream msg;
+            msg << "Coarse state does not contain field `" << stag.name << "` of size " << cx << "x" << cy;
+            throw std::invalid_argument(msg.str());
+        }
+
+        fine.fields.push_back(prolongate_field(*field, h_coarse, size, h, stag, mask));
+    }
+
+    return fine;
+}
+
+}   /* namespace core */
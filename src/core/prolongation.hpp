@@ -0,0 +1,22 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/field_io.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace core {
+
+//! Interpolates the state `coarse` (u, v and p, see `Simulation::state()`)
+//! bilinearly to the grid of the given size (including boundary cells) of
+//! the same domain, typically a refinement.
+//!
+//! `boundary` holds the cell types of the target grid (only the self-tag is
+//! used). Coarse samples located in obstacle cells of the target grid are
+//! excluded from the interpolation, values in obstacle cells are zero. The
+//! result is not divergence-free, the first projection step corrects it.
+auto prolongate(FieldSet const& coarse, ivec2 size, std::vector<std::uint8_t> const& boundary) -> FieldSet;
+
+}   /* namespace core */
@@ -0,0 +1,209 @@
+#include "core/result_cache.hpp"
+
+#include "core/kernel/sources/resources.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+//! Version of the host-side solver and the cache layout, increment on any
+//! change that affects results but not the kernel sources.
+const std::uint32_t CACHE_VERSION = 2;
+
+//! 64-bit FNV-1a hash.
+class Hash {
+public:
+    inline void add(void const* data, std::size_t len) {
+        auto const* bytes = static_cast<std::uint8_t const*>(data);
+        for (std::size_t i = 0; i < len; i++) {
+            m_value = (m_value ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+
+    template <typename T>
+    inline void add(T const& value) {
+        add(&value, sizeof(T));
+    }
+
+    inline auto value() const -> std::uint64_t {
+        return m_value;
+    }
+
+private:
+    std::uint64_t m_value = 0xcbf29ce484222325ull;
+};
+
+auto path(std::string const& dir, std::string const& file) -> std::string {
+    return dir.empty() ? file : dir + "/" + file;
+}
+
+}   /* namespace */
+
+
+ResultCache::ResultCache(std::string dir)
+    : m_dir{std::move(dir)}
+    , m_mutex{} {}
+
+auto ResultCache::key(Parameters const& params, Geometry const& geom) -> std::string {
+    namespace res = core::kernel::resources;
+
+    Hash hash;
+    hash.add(CACHE_VERSION);
+
+    // parameters affecting the flow field
+    hash.add(params.re);
+    hash.add(params.omega);
+    hash.add(params.alpha);
+    hash.add(params.dt);
+    hash.add(params.eps);
+    hash.add(params.tau);
+    hash.add(params.itermax);
+    hash.add(static_cast<std::int32_t>(params.timestepping));
+    hash.add(static_cast<std::int32_t>(params.integrator));
+    hash.add(static_cast<std::uint8_t>(params.implicit_diffusion));
+    hash.add(params.diff_iter);
+
+    // geometry: generator parameters or cells
+    hash.add(geom.size());
+    hash.add(geom.length());
+    hash.add(geom.boundary_velocity());
+    hash.add(geom.boundary_pressure());
+
+    if (geom.is_procedural()) {
+        auto const& gen = geom.generator();
+        hash.add(static_cast<std::int32_t>(gen.type));
+        hash.add(gen.step);
+        hash.add(gen.center);
+        hash.add(gen.count);
+        hash.add(gen.spacing);
+        hash.add(gen.radius);
+        hash.add(gen.start);
+        hash.add(gen.end);
+        hash.add(gen.grain);
+        hash.add(gen.density);
+        hash.add(gen.seed);
+    } else {
+        hash.add(geom.data().data(), geom.data().size());
+    }
+
+    // kernel sources
+    for (auto const& source : {
+        res::zero_cl, res::arith_cl, res::statistics_cl, res::probes_cl, res::forces_cl, res::boundaries_cl,
+        res::momentum_cl, res::diffusion_cl, res::rhs_cl, res::solver_cl, res::velocities_cl, res::reduce_cl,
+        res::geometry_cl,
+    }) {
+        hash.add(source.size());
+        hash.add(source.data(), source.size());
+    }
+
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash.value();
+    return key.str();
+}
+
+auto ResultCache::steady_key(Parameters const& params) -> std::string {
+    if (params.steady_eps <= 0.0) {
+        return "-";
+    }
+
+    Hash hash;
+    hash.add(params.steady_eps);
+    hash.add(params.steady_interval);
+    hash.add(params.steady_window);
+    hash.add(static_cast<std::int32_t>(params.steady_norm));
+
+    std::stringstream key;
+    key << std::hex << std::setw(8) << std::setfill('0') << static_cast<std::uint32_t>(hash.value());
+    return key.str();
+}
+
+auto ResultCache::find(std::string const& key, real_t t_end, std::string const& steady_key, CacheEntry& entry) const
+    -> bool
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    std::ifstream index{path(m_dir, key + ".index")};
+    if (!index) {
+        return false;
+    }
+
+    bool found = false;
+    bool result = false;
+
+    std::string line;
+    while (std::getline(index, line)) {
+        std::stringstream linestr{line};
+
+        auto e = CacheEntry{};
+        linestr >> e.t_prev >> e.t >> e.residual >> e.steady >> e.steady_key >> e.file;
+
+        if (linestr.fail()) {
+            continue;                   // incomplete line of a concurrent writer
+        }
+
+        // a run to t_end performs the step from t_prev only if t_prev < t_end
+        if (!(e.t_prev < t_end)) {
+            continue;
+        }
+
+        // the run stops at the first steady state of its settings, otherwise continues with the latest state
+        bool const steady = e.steady && e.steady_key == steady_key;
+        if (steady ? (!result || e.t < entry.t) : (!result && (!found || e.t > entry.t))) {
+            entry = e;
+            found = true;
+            result = steady;
+        }
+    }
+
+    return found;
+}
+
+auto ResultCache::load(CacheEntry const& entry) const -> FieldSet {
+    auto state = FieldSet::load(path(m_dir, entry.file).c_str());
+    state.time = entry.t;
+
+    return state;
+}
+
+void ResultCache::store(std::string const& key, CacheEntry entry, FieldSet const& state) {
+    static_assert(sizeof(real_t) == sizeof(std::uint32_t), "state file names assume single precision");
+
+    std::uint32_t time_bits;
+    std::memcpy(&time_bits, &state.time, sizeof(time_bits));
+
+    std::stringstream file;
+    file << key << "-" << std::hex << std::setw(8) << std::setfill('0') << time_bits << ".field";
+
+    entry.t = state.time;
+    entry.file = file.str();
+
+    // the state is complete before it is referenced by the index
+    state.save(path(m_dir, entry.file).c_str());
+
+    std::stringstream line;
+    line << std::setprecision(std::numeric_limits<real_t>::max_digits10)
+         << entry.t_prev << " " << entry.t << " " << entry.residual << " " << (entry.steady ? 1 : 0) << " "
+         << (entry.steady ? entry.steady_key : "-") << " " << entry.file << "\n";
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    auto const index_file = path(m_dir, key + ".index");
+    std::ofstream index{index_file, std::ios::app};
+    index << line.str() << std::flush;
+
+    if (!index) {
+        std::stringstream msg;
+        msg << "Failed to write cache index `" << index_file << "`";
+        throw std::runtime_error(msg.str());
+    }
+}
+
+}   /* namespace core */
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/parameters.hpp"
+#include "core/geometry.hpp"
+#include "core/field_io.hpp"
+
+#include <mutex>
+#include <string>
+
+
+namespace core {
+
+//! Stored state of a cached configuration.
+struct CacheEntry {
+    real_t t_prev;                  //!< time before the step that reached `t`
+    real_t t;                       //!< time of the state
+    real_t residual;                //!< pressure residual of the last step
+    bool steady;
+    std::string steady_key;         //!< steady-state detection settings if `steady` (see `steady_key()`), else "-"
+    std::string file;               //!< field file, relative to the cache directory
+};
+
+
+//! Content-addressed cache of simulation states.
+//!
+//! States are stored per configuration, identified by a hash of all
+//! parameters affecting the flow field, the geometry and the kernel sources.
+//! Excluded are `t_end`, steady-state detection and all outputs (statistics,
+//! forces), thus runs of the same configuration to different end times share
+//! their states: a run to `t_end` ends with the first state at or beyond
+//! `t_end`, which is returned directly if stored, otherwise the run can be
+//! resumed from the latest stored state before it. Runs stopping at a steady
+//! state end there instead, thus steady states are stored with the detection
+//! settings and are results of runs with the same settings only.
+//!
+//! Each configuration has an index `<key>.index` of its states (one line of
+//! `t_prev t residual steady steady_key file` per state) in the cache
+//! directory, states are stored as `<key>-<time>.field`. Files are written
+//! atomically and index lines appended, thus the directory may be shared by
+//! multiple processes. Results of different devices are not distinguished.
+class ResultCache {
+public:
+    //! Cache in the given directory, which must exist.
+    ResultCache(std::string dir);
+    ResultCache(ResultCache const&) = delete;
+
+    auto operator= (ResultCache const&) -> ResultCache& = delete;
+
+    //! Key of the configuration (16 hex digits).
+    static auto key(Parameters const& params, Geometry const& geom) -> std::string;
+
+    //! Key of the steady-state detection settings (8 hex digits), "-" if
+    //! the detection is disabled.
+    static auto steady_key(Parameters const& params) -> std::string;
+
+    //! Finds the result of a run to `t_end` with the given steady-state
+    //! detection settings, i.e. the first steady state of these settings
+    //! before `t_end` or, if there is none, the latest stored state the run
+    //! passes through. The state is the result of such a run if
+    //! `is_result()`. Returns false if no such state is stored.
+    auto find(std::string const& key, real_t t_end, std::string const& steady_key, CacheEntry& entry) const
+        -> bool;
+
+    //! Whether the entry returned by `find()` is the result of the run.
+    static inline auto is_result(CacheEntry const& entry, real_t t_end, std::string const& steady_key) -> bool;
+
+    //! Loads the state of the given entry.
+    auto load(CacheEntry const& entry) const -> FieldSet;
+
+    //! Stores the state, `entry.t` and `entry.file` are set from the state.
+    void store(std::string const& key, CacheEntry entry, FieldSet const& state);
+
+    inline auto directory() const -> std::string const&;
+
+private:
+    std::string m_dir;
+    mutable std::mutex m_mutex;
+};
+
+
+auto ResultCache::is_result(CacheEntry const& entry, real_t t_end, std::string const& steady_key) -> bool {
+    return entry.t >= t_end || (entry.steady && entry.steady_key == steady_key);
+}
+
+auto ResultCache::directory() const -> std::string const& {
+    return m_dir;
+}
+
+}   /* namespace core */
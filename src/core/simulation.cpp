@@ -0,0 +1,1071 @@
+#include "core/simulation.hpp"
+#include "core/prolongation.hpp"
+
+#include "utils/pad.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+const uint_t REDUCE_LOCAL_SIZE = 128;
+
+// time-averaged statistics: 6 planes (mean u, v, p; M2 uu, vv, uv)
+const uint_t STATS_PLANES = 6;
+
+auto buffer_size(cl::Buffer const& buf) -> std::size_t {
+    return buf() ? buf.getInfo<CL_MEM_SIZE>() : 0;
+}
+
+//! Throws if the state has been computed on a domain of a different length.
+void check_domain(FieldSet const& state, rvec2 length) {
+    if (std::abs(state.length.x - length.x) > 1e-5f * length.x
+            || std::abs(state.length.y - length.y) > 1e-5f * length.y) {
+        std::stringstream msg;
+        msg << "State of domain " << state.length.x << "x" << state.length.y
+            << " does not match geometry of domain " << length.x << "x" << length.y;
+        throw std::invalid_argument(msg.str());
+    }
+}
+
+//! Temporary buffer of the pool, released when leaving the scope.
+class TemporaryBuffer {
+public:
+    TemporaryBuffer(BufferPool& pool, std::size_t size)
+        : m_pool{pool}
+        , m_buffer{pool.acquire(size, CL_MEM_READ_WRITE)} {}
+
+    TemporaryBuffer(TemporaryBuffer const&) = delete;
+
+    ~TemporaryBuffer() {
+        m_pool.release(m_buffer);
+    }
+
+    auto operator= (TemporaryBuffer const&) -> TemporaryBuffer& = delete;
+
+    inline auto buffer() -> cl::Buffer& {
+        return m_buffer;
+    }
+
+private:
+    BufferPool& m_pool;
+    cl::Buffer m_buffer;
+};
+
+}   /* namespace */
+
+
+FieldView::FieldView(cl::CommandQueue const& queue, cl::Buffer const& buffer, ivec2 size,
+                     std::shared_ptr<void> lock)
+    : m_queue{queue}
+    , m_buffer{buffer}
+    , m_size{size}
+    , m_data{nullptr}
+    , m_lock{std::move(lock)}
+{
+    auto const bytes = static_cast<std::size_t>(size.x) * size.y * sizeof(cl_float);
+    m_data = static_cast<cl_float const*>(m_queue.enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_READ, 0, bytes));
+}
+
+FieldView::~FieldView() {
+    if (m_data) {
+        m_queue.enqueueUnmapMemObject(m_buffer, const_cast<cl_float*>(m_data));
+    }
+}
+
+
+Simulation::Simulation(Engine& engine, Parameters params, Geometry geom, std::ostream& log)
+    : m_engine{engine}
+    , m_log{log}
+    , m_params{std::move(params)}
+    , m_geom{std::move(geom)}
+    , m_timer{engine.queue(), TimerMode::Disabled}
+    , m_local_dt{m_params.timestepping == TimeStepping::Local}
+    , m_implicit_diffusion{m_params.implicit_diffusion && !m_local_dt}
+    , m_integrator{m_local_dt ? Integrator::Euler : m_params.integrator}
+    , m_steady{m_params.steady_eps, m_params.steady_window}
+    , m_steady_has_ref{false}
+    , m_n_fluid_cells{m_geom.num_fluid_cells()}
+    , m_n_stats_samples{0}
+    , m_device_memory{0}
+    , m_t{0.0}
+    , m_dt{m_params.dt}
+    , m_n_steps{0}
+    , m_n_sor_iter{0}
+    , m_n_sor_iter_total{0}
+    , m_residual{0.0}
+    , m_u_abs_max{0.0}
+    , m_v_abs_max{0.0}
+    , m_views{std::make_shared<char>(0)}
+{
+    // the destructor does not run if the constructor throws, buffers acquired so far are returned here
+    try {
+        init();
+    } catch (...) {
+        release_buffers();
+        throw;
+    }
+}
+
+Simulation::~Simulation() {
+    release_buffers();
+}
+
+void Simulation::init() {
+    auto const& context = m_engine.context();
+    auto const& programs = m_engine.programs();
+    auto& pool = m_engine.pool();
+    auto const size = m_geom.size();
+
+    if (m_params.implicit_diffusion && m_local_dt) {
+        m_log << "WARNING: implicit diffusion is not supported with local time-stepping, ignoring\n";
+    }
+
+    if (m_params.integrator != Integrator::Euler && m_local_dt) {
+        m_log << "WARNING: higher-order integrators are not supported with local time-stepping, ignoring\n";
+    }
+
+    init_boundary();
+
+    // create component buffers
+    m_buf_u_size = (size.x + 1) * size.y * sizeof(cl_float);
+    m_buf_u = pool.acquire(m_buf_u_size, CL_MEM_READ_WRITE);
+    m_buf_f = pool.acquire(m_buf_u_size, CL_MEM_READ_WRITE);
+
+    m_buf_v_size = size.x * (size.y + 1) * sizeof(cl_float);
+    m_buf_v = pool.acquire(m_buf_v_size, CL_MEM_READ_WRITE);
+    m_buf_g = pool.acquire(m_buf_v_size, CL_MEM_READ_WRITE);
+
+    m_buf_p_size = size.x * size.y * sizeof(cl_float);
+    m_buf_p = pool.acquire(m_buf_p_size, CL_MEM_READ_WRITE);
+
+    auto const buf_rhs_size = (size.x - 2) * (size.y - 2) * sizeof(cl_float);
+    m_buf_rhs = pool.acquire(buf_rhs_size, CL_MEM_READ_WRITE);
+
+    // transient scratch buffer, only live within a phase of a step: local residual of the pressure
+    // solver and explicit part of F for implicit diffusion (dead once the diffusion has finished)
+    m_buf_scratch = pool.acquire(m_implicit_diffusion ? m_buf_u_size : m_buf_p_size, CL_MEM_READ_WRITE);
+
+    // pressure increment for local time-stepping (pseudo-time steady mode)
+    if (m_local_dt) {
+        m_buf_phi = pool.acquire(m_buf_p_size, CL_MEM_READ_WRITE);
+    }
+
+    // right-hand sides for implicit diffusion (explicit part of F and G), F uses the scratch buffer
+    if (m_implicit_diffusion) {
+        m_buf_g_rhs = pool.acquire(m_buf_v_size, CL_MEM_READ_WRITE);
+    }
+
+    // initial state of the step for higher-order integrators
+    if (m_integrator != Integrator::Euler) {
+        m_buf_u_n = pool.acquire(m_buf_u_size, CL_MEM_READ_WRITE);
+        m_buf_v_n = pool.acquire(m_buf_v_size, CL_MEM_READ_WRITE);
+    }
+
+    if (m_params.stats) {
+        m_buf_stats = pool.acquire(STATS_PLANES * m_buf_p_size, CL_MEM_READ_WRITE);
+    }
+
+    // obstacle forces: recorded after each step
+    if (m_params.forces) {
+        m_forces = std::make_unique<ForceRecorder>(context, programs.forces, m_params.forces_file,
+                                                   m_params.force_ref_velocity, m_params.force_ref_length, size);
+        m_forces->update_interfaces(m_engine.tracer(), m_engine.queue(), m_buf_boundary);
+    }
+
+    // initialize reduction stuff
+    m_reduce_res_size = (size.x - 2) * (size.y - 2);
+    m_reduce_u_size = (size.x + 1) * size.y;
+    m_reduce_v_size = size.x * (size.y + 1);
+
+    uint_t const reduce_output_size_res = utils::pad_up(m_reduce_res_size, REDUCE_LOCAL_SIZE) / REDUCE_LOCAL_SIZE;
+    uint_t const reduce_output_size_u = utils::pad_up(m_reduce_u_size, REDUCE_LOCAL_SIZE) / REDUCE_LOCAL_SIZE;
+    uint_t const reduce_output_size_v = utils::pad_up(m_reduce_v_size, REDUCE_LOCAL_SIZE) / REDUCE_LOCAL_SIZE;
+
+    m_buf_reduce_out_res = pool.acquire(reduce_output_size_res * sizeof(cl_float), CL_MEM_WRITE_ONLY);
+    m_buf_reduce_out_u = pool.acquire(reduce_output_size_u * sizeof(cl_float), CL_MEM_WRITE_ONLY);
+    m_buf_reduce_out_v = pool.acquire(reduce_output_size_v * sizeof(cl_float), CL_MEM_WRITE_ONLY);
+
+    m_vec_reduce_out_res.resize(reduce_output_size_res);
+    m_vec_reduce_out_u.resize(reduce_output_size_u);
+    m_vec_reduce_out_v.resize(reduce_output_size_v);
+
+    // steady-state detection: velocity snapshot of the last monitored step
+    if (m_steady.enabled()) {
+        m_buf_u_prev = pool.acquire(m_buf_u_size, CL_MEM_READ_WRITE);
+        m_buf_v_prev = pool.acquire(m_buf_v_size, CL_MEM_READ_WRITE);
+
+        m_buf_reduce_out_steady_u = pool.acquire(2 * reduce_output_size_u * sizeof(cl_float), CL_MEM_WRITE_ONLY);
+        m_buf_reduce_out_steady_v = pool.acquire(2 * reduce_output_size_v * sizeof(cl_float), CL_MEM_WRITE_ONLY);
+
+        m_vec_reduce_out_steady_u.resize(2 * reduce_output_size_u);
+        m_vec_reduce_out_steady_v.resize(2 * reduce_output_size_v);
+    }
+
+    // device memory in use by the simulation buffers
+    for (auto const* buf : {
+        &m_buf_boundary, &m_buf_u, &m_buf_v, &m_buf_f, &m_buf_g, &m_buf_p, &m_buf_rhs, &m_buf_scratch,
+        &m_buf_phi, &m_buf_g_rhs, &m_buf_u_n, &m_buf_v_n, &m_buf_stats, &m_buf_u_prev, &m_buf_v_prev,
+        &m_buf_reduce_out_res, &m_buf_reduce_out_u, &m_buf_reduce_out_v,
+        &m_buf_reduce_out_steady_u, &m_buf_reduce_out_steady_v,
+    }) {
+        m_device_memory += buffer_size(*buf);
+    }
+
+    // initialize fields, g_rhs is written at fluid faces only but copied into G as a whole
+    for (auto const* buf : {
+        &m_buf_u, &m_buf_v, &m_buf_f, &m_buf_g, &m_buf_p, &m_buf_rhs, &m_buf_g_rhs, &m_buf_stats,
+    }) {
+        if (!(*buf)()) {
+            continue;
+        }
+
+        cl::Kernel kernel{programs.zero, "zero_float"};
+        kernel.setArg(0, *buf);
+
+        auto range = cl::NDRange(buffer_size(*buf) / sizeof(cl_float));
+        m_engine.enqueue(kernel, range, cl::NullRange);
+    }
+}
+
+void Simulation::release_buffers() {
+    auto& pool = m_engine.pool();
+
+    // the engine's queue is in-order, pending commands complete before the buffers are reused
+    for (auto* buf : {
+        &m_buf_boundary, &m_buf_u, &m_buf_v, &m_buf_f, &m_buf_g, &m_buf_p, &m_buf_rhs, &m_buf_scratch,
+        &m_buf_phi, &m_buf_g_rhs, &m_buf_u_n, &m_buf_v_n, &m_buf_stats, &m_buf_u_prev, &m_buf_v_prev,
+        &m_buf_reduce_out_res, &m_buf_reduce_out_u, &m_buf_reduce_out_v,
+        &m_buf_reduce_out_steady_u, &m_buf_reduce_out_steady_v,
+    }) {
+        pool.release(*buf);
+        *buf = cl::Buffer{};
+    }
+}
+
+void Simulation::init_boundary() {
+    auto const& queue = m_engine.queue();
+    auto const& program = m_engine.programs().geometry;
+    auto& pool = m_engine.pool();
+
+    // set boundary buffer: upload or generate cell types, neighbor bits are derived on the device
+    auto const n_cells = static_cast<std::size_t>(m_geom.size().x) * m_geom.size().y;
+    m_buf_boundary = pool.acquire(n_cells * sizeof(cl_uchar), CL_MEM_READ_WRITE);
+
+    {
+        TemporaryBuffer tmp_boundary_self{pool, n_cells * sizeof(cl_uchar)};
+        auto& buf_boundary_self = tmp_boundary_self.buffer();
+        auto range = cl::NDRange(m_geom.size().x, m_geom.size().y);
+
+        if (m_geom.is_procedural()) {
+            auto const& gen = m_geom.generator();
+            cl_float2 h = {{ static_cast<cl_float>(m_geom.mesh().x), static_cast<cl_float>(m_geom.mesh().y) }};
+            cl::Kernel kernel;
+
+            if (gen.type == GeneratorType::ChannelStep) {
+                cl_float2 step = {{ static_cast<cl_float>(gen.step.x), static_cast<cl_float>(gen.step.y) }};
+
+                kernel = {program, "generate_channel_step"};
+                kernel.setArg(0, buf_boundary_self);
+                kernel.setArg(1, h);
+                kernel.setArg(2, step);
+
+            } else if (gen.type == GeneratorType::Cylinders || gen.type == GeneratorType::Karman) {
+                // Karman vortex street: cylinder parameters are set when loading the geometry
+                auto center  = cl_float2{{ static_cast<cl_float>(gen.center.x),  static_cast<cl_float>(gen.center.y)  }};
+                auto count   = cl_int2  {{ static_cast<cl_int>(gen.count.x),     static_cast<cl_int>(gen.count.y)     }};
+                auto spacing = cl_float2{{ static_cast<cl_float>(gen.spacing.x), static_cast<cl_float>(gen.spacing.y) }};
+                auto radius  = static_cast<cl_float>(gen.radius);
+
+                kernel = {program, "generate_cylinders"};
+                kernel.setArg(0, buf_boundary_self);
+                kernel.setArg(1, h);
+                kernel.setArg(2, center);
+                kernel.setArg(3, count);
+                kernel.setArg(4, spacing);
+                kernel.setArg(5, radius);
+
+            } else if (gen.type == GeneratorType::Porous) {
+                cl_float2 start = {{ static_cast<cl_float>(gen.start.x), static_cast<cl_float>(gen.start.y) }};
+                cl_float2 end   = {{ static_cast<cl_float>(gen.end.x),   static_cast<cl_float>(gen.end.y)   }};
+
+                kernel = {program, "generate_porous"};
+                kernel.setArg(0, buf_boundary_self);
+                kernel.setArg(1, h);
+                kernel.setArg(2, start);
+                kernel.setArg(3, end);
+                kernel.setArg(4, static_cast<cl_float>(gen.grain));
+                kernel.setArg(5, static_cast<cl_float>(gen.density));
+                kernel.setArg(6, static_cast<cl_uint>(gen.seed));
+            }
+
+            m_engine.enqueue(kernel, range, cl::NullRange);
+
+        } else {
+            cl::copy(queue, m_geom.data().begin(), m_geom.data().end(), buf_boundary_self);
+        }
+
+        cl::Kernel kernel{program, "set_neighbor_bits"};
+        kernel.setArg(0, buf_boundary_self);
+        kernel.setArg(1, m_buf_boundary);
+
+        m_engine.enqueue(kernel, range, cl::NullRange);
+    }
+
+    // count fluid cells of generated geometry on the device
+    if (m_geom.is_procedural()) {
+        uint_t const count_global_size = utils::pad_up(static_cast<uint_t>(n_cells), REDUCE_LOCAL_SIZE);
+
+        TemporaryBuffer tmp_count{pool, sizeof(cl_uint)};
+        auto& buf_count = tmp_count.buffer();
+
+        queue.enqueueFillBuffer(buf_count, cl_uint{0}, 0, sizeof(cl_uint));
+
+        cl::Kernel kernel{program, "count_fluid"};
+        kernel.setArg(0, m_buf_boundary);
+        kernel.setArg(1, buf_count);
+        kernel.setArg(2, cl::Local(REDUCE_LOCAL_SIZE * sizeof(cl_uint)));
+        kernel.setArg(3, static_cast<cl_uint>(n_cells));
+
+        m_engine.enqueue(kernel, cl::NDRange(count_global_size), cl::NDRange(REDUCE_LOCAL_SIZE));
+
+        cl_uint count = 0;
+        queue.enqueueReadBuffer(buf_count, CL_TRUE, 0, sizeof(cl_uint), &count);
+        m_n_fluid_cells = count;
+    }
+}
+
+void Simulation::set_probes(ProbeSet probes) {
+    m_probes = std::make_unique<ProbeRecorder>(m_engine.context(), m_engine.programs().probes, std::move(probes));
+}
+
+void Simulation::update_geometry() {
+    if (!m_geom.is_dirty()) {
+        return;
+    }
+
+    // upload only the dirty region (including neighbor bits)
+    auto const& region = m_geom.dirty_region();
+
+    auto const origin = cl::array<cl::size_type, 3>{{
+        static_cast<cl::size_type>(region.min.x),
+        static_cast<cl::size_type>(region.min.y),
+        0,
+    }};
+
+    auto const extent = cl::array<cl::size_type, 3>{{
+        static_cast<cl::size_type>(region.max.x - region.min.x),
+        static_cast<cl::size_type>(region.max.y - region.min.y),
+        1,
+    }};
+
+    auto const pitch = static_cast<cl::size_type>(m_geom.size().x) * sizeof(cl_uchar);
+
+    m_engine.queue().enqueueWriteBufferRect(m_buf_boundary, CL_TRUE, origin, origin, extent, pitch, 0, pitch, 0,
+                                            m_geom.data().data());
+
+    m_geom.clear_dirty();
+    m_n_fluid_cells = m_geom.num_fluid_cells();
+
+    // geometry changed, the flow is no longer steady
+    m_steady.reset();
+    m_steady_has_ref = false;
+
+    if (m_forces) {
+        m_forces->update_interfaces(m_engine.tracer(), m_engine.queue(), m_buf_boundary);
+    }
+}
+
+void Simulation::step() {
+    check_unmapped();
+
+    auto const& queue = m_engine.queue();
+    auto zone_step = m_engine.tracer().zone("step");
+
+    update_geometry();
+    m_n_sor_iter = 0;
+
+    set_velocity_boundaries();
+
+    {   // set pressure boundary    // TODO: only required initially
+        cl::Kernel kernel_boundary_p{m_engine.programs().boundaries, "set_boundary_p"};
+        kernel_boundary_p.setArg(0, m_buf_p);
+        kernel_boundary_p.setArg(1, m_buf_boundary);
+        kernel_boundary_p.setArg(2, static_cast<cl_float>(m_geom.boundary_pressure()));
+
+        auto range = cl::NDRange(m_geom.size().x, m_geom.size().y);
+        m_engine.enqueue(kernel_boundary_p, range, cl::NullRange);
+    }
+
+    update_dt();
+
+    // store initial state for higher-order integrators
+    if (m_integrator != Integrator::Euler) {
+        queue.enqueueCopyBuffer(m_buf_u, m_buf_u_n, 0, 0, m_buf_u_size);
+        queue.enqueueCopyBuffer(m_buf_v, m_buf_v_n, 0, 0, m_buf_v_size);
+    }
+
+    advance();
+
+    // higher-order integrators: additional stages, combined with the initial state
+    if (m_integrator != Integrator::Euler) {
+        set_velocity_boundaries();
+        advance();
+
+        if (m_integrator == Integrator::Rk3) {
+            combine_stage(0.75, 0.25);
+
+            set_velocity_boundaries();
+            advance();
+
+            combine_stage(1.0 / 3.0, 2.0 / 3.0);
+        } else {
+            combine_stage(0.5, 0.5);
+        }
+    }
+
+    m_t += m_dt;
+    m_n_steps += 1;
+    m_n_sor_iter_total += m_n_sor_iter;
+
+    if (m_probes) {
+        m_probes->record(m_engine.tracer(), queue, m_buf_u, m_buf_v, m_buf_p, m_geom.size(), m_geom.mesh(), m_t);
+    }
+
+    if (m_forces) {
+        m_forces->record(m_engine.tracer(), queue, m_buf_p, m_buf_u, m_buf_v, m_geom.mesh(), m_params.re, m_t);
+    }
+
+    update_statistics();
+    update_steady();
+}
+
+auto Simulation::advance_to(real_t t) -> uint_t {
+    check_unmapped();
+
+    uint_t n = 0;
+    while (m_t < t && !m_steady.is_steady()) {
+        step();
+        n += 1;
+    }
+
+    return n;
+}
+
+void Simulation::set_velocity_boundaries() {
+    auto const& program = m_engine.programs().boundaries;
+
+    {   // set u boundary
+        cl::Kernel kernel_boundary_u{program, "set_boundary_u"};
+        kernel_boundary_u.setArg(0, m_buf_u);
+        kernel_boundary_u.setArg(1, m_buf_boundary);
+        kernel_boundary_u.setArg(2, static_cast<cl_float>(m_geom.boundary_velocity().x));
+
+        auto range = cl::NDRange(m_geom.size().x, m_geom.size().y);
+        m_engine.enqueue(kernel_boundary_u, range, cl::NullRange);
+    }
+
+    {   // set v boundary
+        cl::Kernel kernel_boundary_v{program, "set_boundary_v"};
+        kernel_boundary_v.setArg(0, m_buf_v);
+        kernel_boundary_v.setArg(1, m_buf_boundary);
+        kernel_boundary_v.setArg(2, static_cast<cl_float>(m_geom.boundary_velocity().y));
+
+        auto range = cl::NDRange(m_geom.size().x, m_geom.size().y);
+        m_engine.enqueue(kernel_boundary_v, range, cl::NullRange);
+    }
+}
+
+void Simulation::update_dt() {
+    auto phase = m_timer.scope(Phase::Dt);
+
+    auto const& program = m_engine.programs().reduce;
+    uint_t const reduce_global_size_u = utils::pad_up(m_reduce_u_size, REDUCE_LOCAL_SIZE);
+    uint_t const reduce_global_size_v = utils::pad_up(m_reduce_v_size, REDUCE_LOCAL_SIZE);
+
+    // calculate maximum absolutes for u and v
+    cl::Kernel kernel_u{program, "reduce_max_abs"};
+    kernel_u.setArg(0, m_buf_u);
+    kernel_u.setArg(1, m_buf_reduce_out_u);
+    kernel_u.setArg(2, cl::Local(REDUCE_LOCAL_SIZE * sizeof(cl_float)));
+    kernel_u.setArg(3, static_cast<cl_uint>(m_reduce_u_size));
+
+    m_engine.enqueue(kernel_u, cl::NDRange(reduce_global_size_u), cl::NDRange(REDUCE_LOCAL_SIZE));
+
+    cl::Kernel kernel_v{program, "reduce_max_abs"};
+    kernel_v.setArg(0, m_buf_v);
+    kernel_v.setArg(1, m_buf_reduce_out_v);
+    kernel_v.setArg(2, cl::Local(REDUCE_LOCAL_SIZE * sizeof(cl_float)));
+    kernel_v.setArg(3, static_cast<cl_uint>(m_reduce_v_size));
+
+    m_engine.enqueue(kernel_v, cl::NDRange(reduce_global_size_v), cl::NDRange(REDUCE_LOCAL_SIZE));
+
+    auto zone = m_engine.tracer().zone("copy max velocity");
+    cl::copy(m_engine.queue(), m_buf_reduce_out_u, m_vec_reduce_out_u.begin(), m_vec_reduce_out_u.end());
+    cl::copy(m_engine.queue(), m_buf_reduce_out_v, m_vec_reduce_out_v.begin(), m_vec_reduce_out_v.end());
+
+    m_u_abs_max = static_cast<real_t>(*std::max_element(m_vec_reduce_out_u.begin(), m_vec_reduce_out_u.end()));
+    m_v_abs_max = static_cast<real_t>(*std::max_element(m_vec_reduce_out_v.begin(), m_vec_reduce_out_v.end()));
+
+    rvec2 const d = m_geom.mesh();
+    real_t const dt_diff = ((d.x*d.x * d.y*d.y) / (d.x*d.x + d.y*d.y)) * m_params.re * static_cast<real_t>(0.5);
+    real_t const dt_conv = std::min(d.x / m_u_abs_max, d.y / m_v_abs_max);
+
+    // the viscous limit does not apply when diffusion is treated implicitly
+    if (m_implicit_diffusion) {
+        m_dt = std::min(m_params.dt, m_params.tau * dt_conv);
+    } else {
+        m_dt = std::min(m_params.dt, m_params.tau * std::min(dt_diff, dt_conv));
+    }
+}
+
+void Simulation::advance() {
+    auto const& queue = m_engine.queue();
+    auto const& programs = m_engine.programs();
+    auto const& params = m_params;
+    auto const& geom = m_geom;
+    auto const dt = m_dt;
+
+    m_timer.start(Phase::Momentum);
+
+    if (m_local_dt) {       // calculate preliminary velocities with local time steps: f, g
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        cl::Kernel kernel_momentum_f{programs.momentum, "momentum_eq_f_local"};
+        kernel_momentum_f.setArg(0, m_buf_u);
+        kernel_momentum_f.setArg(1, m_buf_v);
+        kernel_momentum_f.setArg(2, m_buf_p);
+        kernel_momentum_f.setArg(3, m_buf_f);
+        kernel_momentum_f.setArg(4, m_buf_boundary);
+        kernel_momentum_f.setArg(5, static_cast<cl_float>(params.alpha));
+        kernel_momentum_f.setArg(6, static_cast<cl_float>(params.re));
+        kernel_momentum_f.setArg(7, static_cast<cl_float>(params.tau));
+        kernel_momentum_f.setArg(8, static_cast<cl_float>(params.dt));
+        kernel_momentum_f.setArg(9, h);
+
+        cl::Kernel kernel_momentum_g{programs.momentum, "momentum_eq_g_local"};
+        kernel_momentum_g.setArg(0, m_buf_u);
+        kernel_momentum_g.setArg(1, m_buf_v);
+        kernel_momentum_g.setArg(2, m_buf_p);
+        kernel_momentum_g.setArg(3, m_buf_g);
+        kernel_momentum_g.setArg(4, m_buf_boundary);
+        kernel_momentum_g.setArg(5, static_cast<cl_float>(params.alpha));
+        kernel_momentum_g.setArg(6, static_cast<cl_float>(params.re));
+        kernel_momentum_g.setArg(7, static_cast<cl_float>(params.tau));
+        kernel_momentum_g.setArg(8, static_cast<cl_float>(params.dt));
+        kernel_momentum_g.setArg(9, h);
+
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+        m_engine.enqueue(kernel_momentum_f, range, cl::NullRange);
+        m_engine.enqueue(kernel_momentum_g, range, cl::NullRange);
+
+    } else if (m_implicit_diffusion) {      // calculate preliminary velocities with implicit diffusion: f, g
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+
+        // explicit part: convection, F into the scratch buffer; only fluid faces are written and the buffer
+        // is shared with the residual, clear it so that no stale values are copied into F
+        cl::Kernel kernel_zero{programs.zero, "zero_float"};
+        kernel_zero.setArg(0, m_buf_scratch);
+
+        m_engine.enqueue(kernel_zero, cl::NDRange(m_buf_u_size / sizeof(cl_float)), cl::NullRange);
+
+        cl::Kernel kernel_momentum_f{programs.momentum, "momentum_eq_f_conv"};
+        kernel_momentum_f.setArg(0, m_buf_u);
+        kernel_momentum_f.setArg(1, m_buf_v);
+        kernel_momentum_f.setArg(2, m_buf_scratch);
+        kernel_momentum_f.setArg(3, m_buf_boundary);
+        kernel_momentum_f.setArg(4, static_cast<cl_float>(params.alpha));
+        kernel_momentum_f.setArg(5, static_cast<cl_float>(dt));
+        kernel_momentum_f.setArg(6, h);
+
+        cl::Kernel kernel_momentum_g{programs.momentum, "momentum_eq_g_conv"};
+        kernel_momentum_g.setArg(0, m_buf_u);
+        kernel_momentum_g.setArg(1, m_buf_v);
+        kernel_momentum_g.setArg(2, m_buf_g_rhs);
+        kernel_momentum_g.setArg(3, m_buf_boundary);
+        kernel_momentum_g.setArg(4, static_cast<cl_float>(params.alpha));
+        kernel_momentum_g.setArg(5, static_cast<cl_float>(dt));
+        kernel_momentum_g.setArg(6, h);
+
+        m_engine.enqueue(kernel_momentum_f, range, cl::NullRange);
+        m_engine.enqueue(kernel_momentum_g, range, cl::NullRange);
+
+        // implicit part: diffusion, starting from the explicit result
+        queue.enqueueCopyBuffer(m_buf_scratch, m_buf_f, 0, 0, m_buf_u_size);
+        queue.enqueueCopyBuffer(m_buf_g_rhs, m_buf_g, 0, 0, m_buf_v_size);
+
+        cl_float2 c = {{
+            static_cast<cl_float>(dt / (params.re * geom.mesh().x * geom.mesh().x)),
+            static_cast<cl_float>(dt / (params.re * geom.mesh().y * geom.mesh().y)),
+        }};
+
+        cl::Kernel kernel_diffuse_f{programs.diffusion, "diffuse_f"};
+        kernel_diffuse_f.setArg(0, m_buf_f);
+        kernel_diffuse_f.setArg(1, m_buf_scratch);
+        kernel_diffuse_f.setArg(2, m_buf_boundary);
+        kernel_diffuse_f.setArg(3, c);
+
+        cl::Kernel kernel_diffuse_g{programs.diffusion, "diffuse_g"};
+        kernel_diffuse_g.setArg(0, m_buf_g);
+        kernel_diffuse_g.setArg(1, m_buf_g_rhs);
+        kernel_diffuse_g.setArg(2, m_buf_boundary);
+        kernel_diffuse_g.setArg(3, c);
+
+        cl::Kernel kernel_boundary_f{programs.boundaries, "set_boundary_u"};
+        kernel_boundary_f.setArg(0, m_buf_f);
+        kernel_boundary_f.setArg(1, m_buf_boundary);
+        kernel_boundary_f.setArg(2, static_cast<cl_float>(geom.boundary_velocity().x));
+
+        cl::Kernel kernel_boundary_g{programs.boundaries, "set_boundary_v"};
+        kernel_boundary_g.setArg(0, m_buf_g);
+        kernel_boundary_g.setArg(1, m_buf_boundary);
+        kernel_boundary_g.setArg(2, static_cast<cl_float>(geom.boundary_velocity().y));
+
+        for (int_t iter = 0; iter < params.diff_iter; iter++) {
+            m_engine.enqueue(kernel_boundary_f, range, cl::NullRange);
+            m_engine.enqueue(kernel_boundary_g, range, cl::NullRange);
+
+            for (cl_int color = 0; color < 2; color++) {
+                kernel_diffuse_f.setArg(4, color);
+                kernel_diffuse_g.setArg(4, color);
+
+                m_engine.enqueue(kernel_diffuse_f, range, cl::NullRange);
+                m_engine.enqueue(kernel_diffuse_g, range, cl::NullRange);
+            }
+        }
+
+    } else {
+        {   // calculate preliminary velocities: f
+            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+            cl::Kernel kernel_momentum_f{programs.momentum, "momentum_eq_f"};
+            kernel_momentum_f.setArg(0, m_buf_u);
+            kernel_momentum_f.setArg(1, m_buf_v);
+            kernel_momentum_f.setArg(2, m_buf_f);
+            kernel_momentum_f.setArg(3, m_buf_boundary);
+            kernel_momentum_f.setArg(4, static_cast<cl_float>(params.alpha));
+            kernel_momentum_f.setArg(5, static_cast<cl_float>(params.re));
+            kernel_momentum_f.setArg(6, static_cast<cl_float>(dt));
+            kernel_momentum_f.setArg(7, h);
+
+            auto range = cl::NDRange(geom.size().x, geom.size().y);
+            m_engine.enqueue(kernel_momentum_f, range, cl::NullRange);
+        }
+
+        {   // calculate preliminary velocities: g
+            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+            cl::Kernel kernel_momentum_g{programs.momentum, "momentum_eq_g"};
+            kernel_momentum_g.setArg(0, m_buf_u);
+            kernel_momentum_g.setArg(1, m_buf_v);
+            kernel_momentum_g.setArg(2, m_buf_g);
+            kernel_momentum_g.setArg(3, m_buf_boundary);
+            kernel_momentum_g.setArg(4, static_cast<cl_float>(params.alpha));
+            kernel_momentum_g.setArg(5, static_cast<cl_float>(params.re));
+            kernel_momentum_g.setArg(6, static_cast<cl_float>(dt));
+            kernel_momentum_g.setArg(7, h);
+
+            auto range = cl::NDRange(geom.size().x, geom.size().y);
+            m_engine.enqueue(kernel_momentum_g, range, cl::NullRange);
+        }
+    }
+
+    m_timer.stop();
+
+    // projection: with local time steps, solve for a pressure increment with unit time step
+    m_timer.start(Phase::Pressure);
+
+    auto const& buf_p_solve = m_local_dt ? m_buf_phi : m_buf_p;
+    cl_float const dt_solve = m_local_dt ? 1.0f : static_cast<cl_float>(dt);
+    cl_float const p_in_solve = m_local_dt ? 0.0f : static_cast<cl_float>(geom.boundary_pressure());
+
+    if (m_local_dt) {       // initialize pressure increment
+        cl::Kernel kernel{programs.zero, "zero_float"};
+        kernel.setArg(0, m_buf_phi);
+
+        auto range = cl::NDRange(geom.size().x * geom.size().y);
+        m_engine.enqueue(kernel, range, cl::NullRange);
+    }
+
+    {   // set f boundary
+        cl::Kernel kernel_boundary_u{programs.boundaries, "set_boundary_u"};
+        kernel_boundary_u.setArg(0, m_buf_f);
+        kernel_boundary_u.setArg(1, m_buf_boundary);
+        kernel_boundary_u.setArg(2, static_cast<cl_float>(geom.boundary_velocity().x));
+
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+        m_engine.enqueue(kernel_boundary_u, range, cl::NullRange);
+    }
+
+    {   // set g boundary
+        cl::Kernel kernel_boundary_v{programs.boundaries, "set_boundary_v"};
+        kernel_boundary_v.setArg(0, m_buf_g);
+        kernel_boundary_v.setArg(1, m_buf_boundary);
+        kernel_boundary_v.setArg(2, static_cast<cl_float>(geom.boundary_velocity().y));
+
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+        m_engine.enqueue(kernel_boundary_v, range, cl::NullRange);
+    }
+
+    {   // calculate rhs
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        cl::Kernel kernel_rhs{programs.rhs, "compute_rhs"};
+        kernel_rhs.setArg(0, m_buf_f);
+        kernel_rhs.setArg(1, m_buf_g);
+        kernel_rhs.setArg(2, m_buf_rhs);
+        kernel_rhs.setArg(3, m_buf_boundary);
+        kernel_rhs.setArg(4, dt_solve);
+        kernel_rhs.setArg(5, h);
+
+        auto range = cl::NDRange(geom.size().x - 2, geom.size().y - 2);
+        m_engine.enqueue(kernel_rhs, range, cl::NullRange);
+    }
+
+    {   // run solver
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        cl::Kernel kernel_red{programs.solver, "cycle_red"};
+        kernel_red.setArg(0, buf_p_solve);
+        kernel_red.setArg(1, m_buf_rhs);
+        kernel_red.setArg(2, m_buf_boundary);
+        kernel_red.setArg(3, h);
+        kernel_red.setArg(4, static_cast<cl_float>(params.omega));
+
+        cl::Kernel kernel_black{programs.solver, "cycle_black"};
+        kernel_black.setArg(0, buf_p_solve);
+        kernel_black.setArg(1, m_buf_rhs);
+        kernel_black.setArg(2, m_buf_boundary);
+        kernel_black.setArg(3, h);
+        kernel_black.setArg(4, static_cast<cl_float>(params.omega));
+
+        cl::Kernel kernel_boundary_p{programs.boundaries, "set_boundary_p"};
+        kernel_boundary_p.setArg(0, buf_p_solve);
+        kernel_boundary_p.setArg(1, m_buf_boundary);
+        kernel_boundary_p.setArg(2, p_in_solve);
+
+        cl::Kernel kernel_residual{programs.solver, "residual"};
+        kernel_residual.setArg(0, buf_p_solve);
+        kernel_residual.setArg(1, m_buf_rhs);
+        kernel_residual.setArg(2, m_buf_boundary);
+        kernel_residual.setArg(3, m_buf_scratch);
+        kernel_residual.setArg(4, h);
+
+        cl::Kernel kernel_reduce{programs.reduce, "reduce_sum"};
+        kernel_reduce.setArg(0, m_buf_scratch);
+        kernel_reduce.setArg(1, m_buf_reduce_out_res);
+        kernel_reduce.setArg(2, cl::Local(REDUCE_LOCAL_SIZE * sizeof(cl_float)));
+        kernel_reduce.setArg(3, m_reduce_res_size);
+
+        int_t y_cells_black = (geom.size().y - 2) / 2;
+        auto range_red = cl::NDRange(geom.size().x - 2, geom.size().y - 2 - y_cells_black);
+        auto range_black = cl::NDRange(geom.size().x - 2, y_cells_black);
+        auto range_bounds = cl::NDRange(geom.size().x, geom.size().y);
+        auto range_residual = cl::NDRange(geom.size().x - 2, geom.size().y - 2);
+        auto range_reduce = cl::NDRange(utils::pad_up(m_reduce_res_size, REDUCE_LOCAL_SIZE));
+
+        cl_float residual = std::numeric_limits<cl_float>::infinity();
+        int_t iter = 0;
+        for (; iter < params.itermax && residual > params.eps; iter++) {
+            // solver cycles
+            m_engine.enqueue(kernel_red, range_red, cl::NullRange);
+            m_engine.enqueue(kernel_black, range_black, cl::NullRange);
+
+            // update boundaries
+            m_engine.enqueue(kernel_boundary_p, range_bounds, cl::NullRange);
+
+            {   // calculate residual   // TODO: only do once in k solver-iterations
+                m_engine.enqueue(kernel_residual, range_residual, cl::NullRange);
+
+                // reduce residual
+                m_engine.enqueue(kernel_reduce, range_reduce, cl::NDRange(REDUCE_LOCAL_SIZE));
+
+                auto zone = m_engine.tracer().zone("copy residual");
+                cl::copy(queue, m_buf_reduce_out_res, m_vec_reduce_out_res.begin(), m_vec_reduce_out_res.end());
+
+                residual = std::accumulate(m_vec_reduce_out_res.begin(), m_vec_reduce_out_res.end(), static_cast<cl_float>(0.0));
+                residual = residual / m_n_fluid_cells;
+            }
+        }
+
+        m_n_sor_iter += iter;
+        m_residual = residual;
+    }
+
+    m_timer.stop();
+    m_timer.start(Phase::Velocity);
+
+    {   // calculate new velocities
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        cl::Kernel kernel{programs.velocities, "new_velocities"};
+        kernel.setArg(0, buf_p_solve);
+        kernel.setArg(1, m_buf_f);
+        kernel.setArg(2, m_buf_g);
+        kernel.setArg(3, m_buf_u);
+        kernel.setArg(4, m_buf_v);
+        kernel.setArg(5, m_buf_boundary);
+        kernel.setArg(6, dt_solve);
+        kernel.setArg(7, h);
+
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+        m_engine.enqueue(kernel, range, cl::NullRange);
+    }
+
+    if (m_local_dt) {       // accumulate pressure increment
+        cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+        cl::Kernel kernel{programs.velocities, "accumulate_pressure"};
+        kernel.setArg(0, m_buf_p);
+        kernel.setArg(1, m_buf_phi);
+        kernel.setArg(2, m_buf_u);
+        kernel.setArg(3, m_buf_v);
+        kernel.setArg(4, m_buf_boundary);
+        kernel.setArg(5, static_cast<cl_float>(params.re));
+        kernel.setArg(6, static_cast<cl_float>(params.tau));
+        kernel.setArg(7, static_cast<cl_float>(params.dt));
+        kernel.setArg(8, h);
+
+        auto range = cl::NDRange(geom.size().x, geom.size().y);
+        m_engine.enqueue(kernel, range, cl::NullRange);
+    }
+
+    m_timer.stop();
+}
+
+void Simulation::combine_stage(real_t a, real_t b) {
+    auto const& program = m_engine.programs().arith;
+
+    // combine the current stage with the initial state: u = a * u_n + b * u
+    cl::Kernel kernel_u{program, "axpby"};
+    kernel_u.setArg(0, m_buf_u_n);
+    kernel_u.setArg(1, m_buf_u);
+    kernel_u.setArg(2, static_cast<cl_float>(a));
+    kernel_u.setArg(3, static_cast<cl_float>(b));
+
+    cl::Kernel kernel_v{program, "axpby"};
+    kernel_v.setArg(0, m_buf_v_n);
+    kernel_v.setArg(1, m_buf_v);
+    kernel_v.setArg(2, static_cast<cl_float>(a));
+    kernel_v.setArg(3, static_cast<cl_float>(b));
+
+    m_engine.enqueue(kernel_u, cl::NDRange(m_reduce_u_size), cl::NullRange);
+    m_engine.enqueue(kernel_v, cl::NDRange(m_reduce_v_size), cl::NullRange);
+}
+
+void Simulation::update_statistics() {
+    if (!m_params.stats || m_t < m_params.stats_start || m_n_steps % m_params.stats_interval != 0) {
+        return;
+    }
+
+    m_n_stats_samples += 1;
+
+    cl::Kernel kernel{m_engine.programs().statistics, "accumulate_statistics"};
+    kernel.setArg(0, m_buf_u);
+    kernel.setArg(1, m_buf_v);
+    kernel.setArg(2, m_buf_p);
+    kernel.setArg(3, m_buf_boundary);
+    kernel.setArg(4, m_buf_stats);
+    kernel.setArg(5, static_cast<cl_float>(1.0 / m_n_stats_samples));
+
+    auto range = cl::NDRange(m_geom.size().x, m_geom.size().y);
+    m_engine.enqueue(kernel, range, cl::NullRange);
+
+    if (m_params.stats_checkpoint > 0 && m_n_stats_samples % m_params.stats_checkpoint == 0) {
+        write_statistics();
+    }
+}
+
+void Simulation::update_steady() {
+    // steady-state detection: relative change of u and v since the last monitored step
+    if (!m_steady.enabled() || m_n_steps % m_params.steady_interval != 0) {
+        return;
+    }
+
+    auto const& queue = m_engine.queue();
+
+    if (m_steady_has_ref) {
+        bool const l2 = m_params.steady_norm == SteadyNorm::L2;
+        char const* const name = l2 ? "reduce_diff_sum_sq" : "reduce_diff_max_abs";
+
+        cl::Kernel kernel_u{m_engine.programs().reduce, name};
+        kernel_u.setArg(0, m_buf_u);
+        kernel_u.setArg(1, m_buf_u_prev);
+        kernel_u.setArg(2, m_buf_reduce_out_steady_u);
+        kernel_u.setArg(3, cl::Local(2 * REDUCE_LOCAL_SIZE * sizeof(cl_float)));
+        kernel_u.setArg(4, static_cast<cl_uint>(m_reduce_u_size));
+
+        auto const range_u = cl::NDRange(utils::pad_up(m_reduce_u_size, REDUCE_LOCAL_SIZE));
+        m_engine.enqueue(kernel_u, range_u, cl::NDRange(REDUCE_LOCAL_SIZE));
+
+        cl::Kernel kernel_v{m_engine.programs().reduce, name};
+        kernel_v.setArg(0, m_buf_v);
+        kernel_v.setArg(1, m_buf_v_prev);
+        kernel_v.setArg(2, m_buf_reduce_out_steady_v);
+        kernel_v.setArg(3, cl::Local(2 * REDUCE_LOCAL_SIZE * sizeof(cl_float)));
+        kernel_v.setArg(4, static_cast<cl_uint>(m_reduce_v_size));
+
+        auto const range_v = cl::NDRange(utils::pad_up(m_reduce_v_size, REDUCE_LOCAL_SIZE));
+        m_engine.enqueue(kernel_v, range_v, cl::NDRange(REDUCE_LOCAL_SIZE));
+
+        auto& out_u = m_vec_reduce_out_steady_u;
+        auto& out_v = m_vec_reduce_out_steady_v;
+
+        auto zone = m_engine.tracer().zone("copy steady change");
+        cl::copy(queue, m_buf_reduce_out_steady_u, out_u.begin(), out_u.end());
+        cl::copy(queue, m_buf_reduce_out_steady_v, out_v.begin(), out_v.end());
+
+        // first half: difference, second half: reference
+        auto const mid_u = out_u.begin() + out_u.size() / 2;
+        auto const mid_v = out_v.begin() + out_v.size() / 2;
+
+        real_t diff;
+        real_t ref;
+        if (l2) {
+            diff = std::accumulate(out_u.begin(), mid_u, static_cast<real_t>(0.0))
+                 + std::accumulate(out_v.begin(), mid_v, static_cast<real_t>(0.0));
+            ref = std::accumulate(mid_u, out_u.end(), static_cast<real_t>(0.0))
+                + std::accumulate(mid_v, out_v.end(), static_cast<real_t>(0.0));
+
+            diff = std::sqrt(diff);
+            ref = std::sqrt(ref);
+        } else {
+            diff = std::max(*std::max_element(out_u.begin(), mid_u), *std::max_element(out_v.begin(), mid_v));
+            ref = std::max(*std::max_element(mid_u, out_u.end()), *std::max_element(mid_v, out_v.end()));
+        }
+
+        // relative change per step
+        real_t change = 0.0;
+        if (ref > 0.0) {
+            change = diff / (ref * m_params.steady_interval);
+        } else if (diff > 0.0) {
+            change = std::numeric_limits<real_t>::infinity();
+        }
+
+        if (m_steady.update(change)) {
+            m_log << "steady state reached: t = " << m_t << ", change = " << change << "\n";
+        }
+    }
+
+    queue.enqueueCopyBuffer(m_buf_u, m_buf_u_prev, 0, 0, m_buf_u_size);
+    queue.enqueueCopyBuffer(m_buf_v, m_buf_v_prev, 0, 0, m_buf_v_size);
+    m_steady_has_ref = true;
+}
+
+auto Simulation::state() const -> FieldSet {
+    auto const fetch = [&](char const* name, cl::Buffer const& buf, uvec2 size) {
+        auto field = Field{name, size, std::vector<float>(static_cast<std::size_t>(size.x) * size.y)};
+        cl::copy(m_engine.queue(), buf, field.data.begin(), field.data.end());
+        return field;
+    };
+
+    auto const nx = static_cast<uint_t>(m_geom.size().x);
+    auto const ny = static_cast<uint_t>(m_geom.size().y);
+
+    FieldSet set{m_geom.size(), m_geom.length(), m_t, {}};
+    set.fields.push_back(fetch("u", m_buf_u, {nx + 1, ny}));
+    set.fields.push_back(fetch("v", m_buf_v, {nx, ny + 1}));
+    set.fields.push_back(fetch("p", m_buf_p, {nx, ny}));
+
+    return set;
+}
+
+void Simulation::restore(FieldSet const& state) {
+    check_unmapped();
+    check_domain(state, m_geom.length());
+
+    auto const upload = [&](char const* name, cl::Buffer& buf, uvec2 size) {
+        auto const* field = state.find(name);
+
+        if (!field || field->size.x != size.x || field->size.y != size.y) {
+            std::stringstream msg;
+            msg << "State does not contain field `" << name << "` of size " << size.x << "x" << size.y;
+            throw std::invalid_argument(msg.str());
+        }
+
+        cl::copy(m_engine.queue(), field->data.begin(), field->data.end(), buf);
+    };
+
+    auto const nx = static_cast<uint_t>(m_geom.size().x);
+    auto const ny = static_cast<uint_t>(m_geom.size().y);
+
+    upload("u", m_buf_u, {nx + 1, ny});
+    upload("v", m_buf_v, {nx, ny + 1});
+    upload("p", m_buf_p, {nx, ny});
+
+    m_t = state.time;
+    m_steady.reset();
+    m_steady_has_ref = false;
+}
+
+void Simulation::prolongate(FieldSet const& coarse) {
+    check_unmapped();
+    check_domain(coarse, m_geom.length());
+
+    // cell types of this grid, also of generated geometries
+    auto boundary = std::vector<std::uint8_t>(static_cast<std::size_t>(m_geom.size().x) * m_geom.size().y);
+    cl::copy(m_engine.queue(), m_buf_boundary, boundary.begin(), boundary.end());
+
+    restore(core::prolongate(coarse, m_geom.size(), boundary));
+}
+
+void Simulation::check_unmapped() const {
+    // writing a mapped buffer is undefined, views hold a reference to m_views
+    if (m_views.use_count() > 1) {
+        throw std::logic_error("Simulation fields may not be modified while mapped, destroy all views first");
+    }
+}
+
+void Simulation::write_statistics() {
+    if (!m_params.stats) {
+        return;
+    }
+
+    // means and (co-)variances at the cell centers
+    auto const plane = static_cast<std::size_t>(m_geom.size().x) * m_geom.size().y;
+    auto data = std::vector<cl_float>(STATS_PLANES * plane);
+    cl::copy(m_engine.queue(), m_buf_stats, data.begin(), data.end());
+
+    char const* const names[] = {"u_mean", "v_mean", "p_mean", "uu", "vv", "uv"};
+    real_t const scale = m_n_stats_samples > 0 ? static_cast<real_t>(1.0) / m_n_stats_samples : 0.0;
+
+    FieldSet set{m_geom.size(), m_geom.length(), m_t, {}};
+    for (uint_t i = 0; i < STATS_PLANES; i++) {
+        auto field = Field{names[i], {static_cast<uint_t>(m_geom.size().x), static_cast<uint_t>(m_geom.size().y)}, {}};
+        field.data.assign(data.begin() + i * plane, data.begin() + (i + 1) * plane);
+
+        // second moments are stored as sums of squared deviations
+        if (i >= 3) {
+            for (auto& x : field.data) {
+                x *= scale;
+            }
+        }
+
+        set.fields.push_back(std::move(field));
+    }
+
+    set.save(m_params.stats_file.c_str());
+    m_log << "statistics written: " << m_params.stats_file << " (" << m_n_stats_samples << " samples)\n";
+}
+
+void Simulation::finish() {
+    write_statistics();
+
+    if (m_probes) {
+        m_probes->flush(m_engine.queue());
+    }
+
+    if (m_forces) {
+        m_forces->flush(m_engine.queue());
+    }
+}
+
+}   /* namespace core */
@@ -0,0 +1,365 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/engine.hpp"
+#include "core/parameters.hpp"
+#include "core/geometry.hpp"
+#include "core/steady.hpp"
+#include "core/probes.hpp"
+#include "core/forces.hpp"
+#include "core/timing.hpp"
+#include "core/field_io.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+namespace core {
+
+//! Read-only host view of a field on the device. The buffer is mapped for
+//! the lifetime of the view, on devices sharing host memory (e.g. CPUs) this
+//! avoids any copy. Mapped buffers must not be written by the device, thus
+//! the simulation cannot advance while any of its views exists (see
+//! `Simulation::map_u()`). The view holds a copy of `lock` for this purpose.
+class FieldView {
+public:
+    FieldView(cl::CommandQueue const& queue, cl::Buffer const& buffer, ivec2 size, std::shared_ptr<void> lock);
+    FieldView(FieldView const&) = delete;
+    inline FieldView(FieldView&& other);
+    ~FieldView();
+
+    auto operator= (FieldView const&) -> FieldView& = delete;
+
+    inline auto size() const -> ivec2 const&;
+    inline auto data() const -> cl_float const*;
+
+    //! Value at the given position, x is the fastest index.
+    inline auto operator() (int_t x, int_t y) const -> cl_float;
+
+private:
+    cl::CommandQueue m_queue;
+    cl::Buffer m_buffer;
+    ivec2 m_size;
+    cl_float const* m_data;
+    std::shared_ptr<void> m_lock;
+};
+
+
+//! Incompressible flow solver on the device.
+//!
+//! The simulation owns all solver buffers and records the optional outputs
+//! (statistics, probes, forces). Kernels and buffers are taken from the
+//! engine, which can be shared by consecutive simulations. Buffers are
+//! returned to the engine's pool on destruction.
+//!
+//! Modifications of the geometry (see `geometry()`) are uploaded before the
+//! next step, or explicitly via `update_geometry()`. Warnings and status
+//! messages are written to `log`.
+class Simulation {
+public:
+    Simulation(Engine& engine, Parameters params, Geometry geom, std::ostream& log = std::cout);
+    Simulation(Simulation const&) = delete;
+    ~Simulation();
+
+    auto operator= (Simulation const&) -> Simulation& = delete;
+
+    //! Records the given probes after each step.
+    void set_probes(ProbeSet probes);
+
+    //! Uploads the modified region of the geometry, if any.
+    void update_geometry();
+
+    //! Advances by a single time step.
+    void step();
+
+    //! Advances until time `t` has been reached (or the flow is steady),
+    //! returns the number of steps performed.
+    auto advance_to(real_t t) -> uint_t;
+
+    //! Current state (u, v and p including boundary cells).
+    auto state() const -> FieldSet;
+
+    //! Continues from the given state (as returned by `state()`), including
+    //! its time. Steady-state detection starts over. The state must be of the
+    //! same grid and domain length.
+    void restore(FieldSet const& state);
+
+    //! Continues from a state on a different (typically coarser) grid of the
+    //! same domain, interpolated to this grid (see `prolongate()`).
+    void prolongate(FieldSet const& coarse);
+
+    //! Writes the time-averaged statistics (if enabled).
+    void write_statistics();
+
+    //! Writes all pending outputs (statistics, probes, forces).
+    void finish();
+
+    inline auto engine() -> Engine&;
+    inline auto params() const -> Parameters const&;
+    inline auto geometry() -> Geometry&;
+    inline auto geometry() const -> Geometry const&;
+    inline auto timer() -> PhaseTimer&;
+
+    inline auto time() const -> real_t;
+    inline auto dt() const -> real_t;
+    inline auto steps() const -> uint_t;
+    inline auto is_steady() const -> bool;
+
+    //! Pressure solver iterations and final residual of the last step.
+    inline auto sor_iterations() const -> uint_t;
+    inline auto sor_iterations_total() const -> std::uint64_t;
+    inline auto residual() const -> real_t;
+
+    //! Maximum absolute velocities at the start of the last step.
+    inline auto u_abs_max() const -> real_t;
+    inline auto v_abs_max() const -> real_t;
+
+    inline auto fluid_cells() const -> uint_t;
+
+    //! Device memory in use by the simulation buffers in bytes.
+    inline auto device_memory() const -> std::size_t;
+
+    inline auto u() const -> cl::Buffer const&;
+    inline auto v() const -> cl::Buffer const&;
+    inline auto p() const -> cl::Buffer const&;
+    inline auto f() const -> cl::Buffer const&;
+    inline auto g() const -> cl::Buffer const&;
+    inline auto rhs() const -> cl::Buffer const&;
+    inline auto boundary() const -> cl::Buffer const&;
+
+    //! Transient buffer of the size of the pressure field (at least), used
+    //! within a step (residual, right-hand side of implicit diffusion). Free
+    //! for other uses between steps, e.g. as visualization target; its
+    //! contents are undefined after the next step.
+    inline auto scratch() const -> cl::Buffer const&;
+
+    //! Host views of the current fields (including boundary cells). Waits for
+    //! all enqueued steps. Views must be destroyed before the fields are
+    //! modified again: `step()`, `advance_to()`, `restore()` and
+    //! `prolongate()` throw `std::logic_error` while any view exists.
+    inline auto map_u() const -> FieldView;
+    inline auto map_v() const -> FieldView;
+    inline auto map_p() const -> FieldView;
+
+private:
+    void init();
+    void init_boundary();
+    void release_buffers();
+    void set_velocity_boundaries();
+    void advance();
+    void combine_stage(real_t a, real_t b);
+    void update_dt();
+    void update_statistics();
+    void update_steady();
+    void check_unmapped() const;
+
+private:
+    Engine& m_engine;
+    std::ostream& m_log;
+    Parameters m_params;
+    Geometry m_geom;
+    PhaseTimer m_timer;
+
+    bool m_local_dt;
+    bool m_implicit_diffusion;
+    Integrator m_integrator;
+
+    std::size_t m_buf_u_size;
+    std::size_t m_buf_v_size;
+    std::size_t m_buf_p_size;
+
+    cl::Buffer m_buf_boundary;
+    cl::Buffer m_buf_u;
+    cl::Buffer m_buf_f;
+    cl::Buffer m_buf_v;
+    cl::Buffer m_buf_g;
+    cl::Buffer m_buf_p;
+    cl::Buffer m_buf_rhs;
+    cl::Buffer m_buf_scratch;           // residual, f_rhs (implicit diffusion)
+    cl::Buffer m_buf_phi;
+    cl::Buffer m_buf_g_rhs;
+    cl::Buffer m_buf_u_n;
+    cl::Buffer m_buf_v_n;
+    cl::Buffer m_buf_stats;
+
+    uint_t m_reduce_res_size;
+    uint_t m_reduce_u_size;
+    uint_t m_reduce_v_size;
+
+    cl::Buffer m_buf_reduce_out_res;
+    cl::Buffer m_buf_reduce_out_u;
+    cl::Buffer m_buf_reduce_out_v;
+
+    std::vector<cl_float> m_vec_reduce_out_res;
+    std::vector<cl_float> m_vec_reduce_out_u;
+    std::vector<cl_float> m_vec_reduce_out_v;
+
+    SteadyStateMonitor m_steady;
+    bool m_steady_has_ref;
+
+    cl::Buffer m_buf_u_prev;
+    cl::Buffer m_buf_v_prev;
+    cl::Buffer m_buf_reduce_out_steady_u;
+    cl::Buffer m_buf_reduce_out_steady_v;
+
+    std::vector<cl_float> m_vec_reduce_out_steady_u;
+    std::vector<cl_float> m_vec_reduce_out_steady_v;
+
+    std::unique_ptr<ProbeRecorder> m_probes;
+    std::unique_ptr<ForceRecorder> m_forces;
+
+    uint_t m_n_fluid_cells;
+    uint_t m_n_stats_samples;
+    std::size_t m_device_memory;
+
+    real_t m_t;
+    real_t m_dt;
+    uint_t m_n_steps;
+
+    uint_t m_n_sor_iter;
+    std::uint64_t m_n_sor_iter_total;
+    real_t m_residual;
+
+    real_t m_u_abs_max;
+    real_t m_v_abs_max;
+
+    std::shared_ptr<void> m_views;      // shared with all views, in use while any view exists
+};
+
+
+FieldView::FieldView(FieldView&& other)
+    : m_queue{other.m_queue}
+    , m_buffer{other.m_buffer}
+    , m_size{other.m_size}
+    , m_data{other.m_data}
+    , m_lock{std::move(other.m_lock)}
+{
+    other.m_data = nullptr;
+}
+
+auto FieldView::size() const -> ivec2 const& {
+    return m_size;
+}
+
+auto FieldView::data() const -> cl_float const* {
+    return m_data;
+}
+
+auto FieldView::operator() (int_t x, int_t y) const -> cl_float {
+    return m_data[y * m_size.x + x];
+}
+
+
+auto Simulation::engine() -> Engine& {
+    return m_engine;
+}
+
+auto Simulation::params() const -> Parameters const& {
+    return m_params;
+}
+
+auto Simulation::geometry() -> Geometry& {
+    return m_geom;
+}
+
+auto Simulation::geometry() const -> Geometry const& {
+    return m_geom;
+}
+
+auto Simulation::timer() -> PhaseTimer& {
+    return m_timer;
+}
+
+auto Simulation::time() const -> real_t {
+    return m_t;
+}
+
+auto Simulation::dt() const -> real_t {
+    return m_dt;
+}
+
+auto Simulation::steps() const -> uint_t {
+    return m_n_steps;
+}
+
+auto Simulation::is_steady() const -> bool {
+    return m_steady.is_steady();
+}
+
+auto Simulation::sor_iterations() const -> uint_t {
+    return m_n_sor_iter;
+}
+
+auto Simulation::sor_iterations_total() const -> std::uint64_t {
+    return m_n_sor_iter_total;
+}
+
+auto Simulation::residual() const -> real_t {
+    return m_residual;
+}
+
+auto Simulation::u_abs_max() const -> real_t {
+    return m_u_abs_max;
+}
+
+auto Simulation::v_abs_max() const -> real_t {
+    return m_v_abs_max;
+}
+
+auto Simulation::fluid_cells() const -> uint_t {
+    return m_n_fluid_cells;
+}
+
+auto Simulation::device_memory() const -> std::size_t {
+    return m_device_memory;
+}
+
+auto Simulation::u() const -> cl::Buffer const& {
+    return m_buf_u;
+}
+
+auto Simulation::v() const -> cl::Buffer const& {
+    return m_buf_v;
+}
+
+auto Simulation::p() const -> cl::Buffer const& {
+    return m_buf_p;
+}
+
+auto Simulation::f() const -> cl::Buffer const& {
+    return m_buf_f;
+}
+
+auto Simulation::g() const -> cl::Buffer const& {
+    return m_buf_g;
+}
+
+auto Simulation::rhs() const -> cl::Buffer const& {
+    return m_buf_rhs;
+}
+
+auto Simulation::boundary() const -> cl::Buffer const& {
+    return m_buf_boundary;
+}
+
+auto Simulation::scratch() const -> cl::Buffer const& {
+    return m_buf_scratch;
+}
+
+auto Simulation::map_u() const -> FieldView {
+    return {m_engine.queue(), m_buf_u, {m_geom.size().x + 1, m_geom.size().y}, m_views};
+}
+
+auto Simulation::map_v() const -> FieldView {
+    return {m_engine.queue(), m_buf_v, {m_geom.size().x, m_geom.size().y + 1}, m_views};
+}
+
+auto Simulation::map_p() const -> FieldView {
+    return {m_engine.queue(), m_buf_p, m_geom.size(), m_views};
+}
+
+}   /* namespace core */
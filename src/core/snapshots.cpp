@@ -0,0 +1,46 @@
+#include "core/snapshots.hpp"
+
+#include <sys/stat.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+namespace core {
+namespace snapshots {
+
+namespace {
+
+auto is_regular_file(std::string const& path) -> bool {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+}   /* namespace */
+
+auto file(std::string const& dir, std::size_t index) -> std::string {
+    if (index == 0 && is_regular_file(dir)) {
+        return dir;
+    }
+
+    std::stringstream path;
+    path << dir << "/snapshot-" << std::setw(6) << std::setfill('0') << index << ".field";
+    return path.str();
+}
+
+auto count(std::string const& dir) -> std::size_t {
+    if (is_regular_file(dir)) {
+        return 1;
+    }
+
+    std::size_t n = 0;
+    while (std::ifstream{file(dir, n)}) {
+        n += 1;
+    }
+
+    return n;
+}
+
+}   /* namespace snapshots */
+}   /* namespace core */
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace core {
+namespace snapshots {
+
+//! File of the snapshot with the given index in the directory. Snapshots
+//! are states (see `Simulation::state()`) numbered consecutively from zero:
+//!
+//!   <dir>/snapshot-000000.field
+//!   <dir>/snapshot-000001.field
+//!   ...
+//!
+//! A single state file (instead of a directory) is a sequence of one
+//! snapshot, i.e. the file itself for index zero.
+auto file(std::string const& dir, std::size_t index) -> std::string;
+
+//! Number of consecutive snapshots in the directory, starting at index zero,
+//! or one for a single state file.
+auto count(std::string const& dir) -> std::size_t;
+
+}   /* namespace snapshots */
+}   /* namespace core */
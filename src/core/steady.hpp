@@ -0,0 +1,63 @@
+#pragma once
+
+#include "types.hpp"
+
+
+namespace core {
+
+//! Tracks the relative change of the solution between monitored steps and
+//! reports a steady state once the change stayed below `eps` for `window`
+//! consecutive samples.
+class SteadyStateMonitor {
+public:
+    inline SteadyStateMonitor(real_t eps, uint_t window);
+
+    inline auto enabled() const -> bool;
+
+    //! Adds a new sample, returns true if the steady state has been reached.
+    inline auto update(real_t change) -> bool;
+    inline void reset();
+
+    inline auto is_steady() const -> bool;
+    inline auto last_change() const -> real_t;
+
+private:
+    real_t m_eps;
+    uint_t m_window;
+
+    uint_t m_count;
+    real_t m_last_change;
+};
+
+
+SteadyStateMonitor::SteadyStateMonitor(real_t eps, uint_t window)
+    : m_eps{eps}
+    , m_window{window}
+    , m_count{0}
+    , m_last_change{0.0} {}
+
+auto SteadyStateMonitor::enabled() const -> bool {
+    return m_eps > 0.0;
+}
+
+auto SteadyStateMonitor::update(real_t change) -> bool {
+    m_last_change = change;
+    m_count = (change < m_eps) ? m_count + 1 : 0;
+
+    return is_steady();
+}
+
+void SteadyStateMonitor::reset() {
+    m_count = 0;
+    m_last_change = 0.0;
+}
+
+auto SteadyStateMonitor::is_steady() const -> bool {
+    return enabled() && m_count >= m_window;
+}
+
+auto SteadyStateMonitor::last_change() const -> real_t {
+    return m_last_change;
+}
+
+}   /* namespace core */
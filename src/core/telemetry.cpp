@@ -0,0 +1,102 @@
+#include "core/telemetry.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+const auto TELEMETRY_POLL_INTERVAL = std::chrono::milliseconds{10};
+
+}   /* namespace */
+
+
+TelemetryLog::TelemetryLog(char const* file, std::size_t capacity)
+    : m_enabled{file != nullptr}
+    , m_out{}
+    , m_ring{m_enabled ? capacity : 1}
+    , m_shutdown{false}
+    , m_dropped{0}
+    , m_thread{}
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    m_out.open(file, std::ios::trunc);
+    if (!m_out) {
+        std::stringstream msg;
+        msg << "Failed to open telemetry log `" << file << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    m_out << std::setprecision(9);
+    m_out << "step,t,dt,sor_iterations,residual,u_max,v_max";
+    for (std::size_t i = 0; i < NUM_PHASES; i++) {
+        m_out << "," << phase_to_string(static_cast<Phase>(i)) << "_ms";
+    }
+    m_out << "\n";
+
+    m_thread = std::thread{[this]() { writer(); }};
+}
+
+TelemetryLog::~TelemetryLog() {
+    try {
+        close();
+    } catch (...) {
+        // never throw from destructor, the log is incomplete in this case
+    }
+}
+
+void TelemetryLog::close() {
+    if (!m_enabled) {
+        return;
+    }
+
+    m_shutdown.store(true, std::memory_order_release);
+    m_thread.join();
+
+    m_out.close();
+    m_enabled = false;
+}
+
+void TelemetryLog::writer() {
+    StepRecord record;
+
+    while (true) {
+        // check before draining, so that all records pushed before close() are written
+        bool const shutdown = m_shutdown.load(std::memory_order_acquire);
+
+        bool written = false;
+        while (m_ring.try_pop(record)) {
+            write(record);
+            written = true;
+        }
+
+        if (shutdown) {
+            break;
+        }
+
+        if (written) {
+            m_out.flush();
+        } else {
+            std::this_thread::sleep_for(TELEMETRY_POLL_INTERVAL);
+        }
+    }
+}
+
+void TelemetryLog::write(StepRecord const& r) {
+    m_out << r.step << "," << r.t << "," << r.dt << "," << r.sor_iterations << "," << r.residual << ","
+          << r.u_max << "," << r.v_max;
+
+    for (auto time : r.phase_time) {
+        m_out << "," << time;
+    }
+
+    m_out << "\n";
+}
+
+}   /* namespace core */
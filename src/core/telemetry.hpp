@@ -0,0 +1,80 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/timing.hpp"
+#include "utils/spsc_ring.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+
+
+namespace core {
+
+//! Record of a single time step.
+struct StepRecord {
+    uint_t step;
+    real_t t;
+    real_t dt;
+    uint_t sor_iterations;
+    real_t residual;
+    real_t u_max;                                   //!< maximum of |u| used for the step size control
+    real_t v_max;                                   //!< maximum of |v| used for the step size control
+    std::array<float, NUM_PHASES> phase_time;       //!< in ms
+};
+
+
+//! Per-step log, written as CSV by a background thread.
+//!
+//! Records are handed over via a lock-free ring buffer, thus `push` never
+//! blocks the simulation loop. If the writer cannot keep up and the buffer is
+//! full, records are dropped and counted instead.
+//!
+//! If no output file is given, the log is disabled and all calls are no-ops.
+class TelemetryLog {
+public:
+    TelemetryLog(char const* file, std::size_t capacity = 1 << 14);
+    TelemetryLog(TelemetryLog const&) = delete;
+    ~TelemetryLog();
+
+    inline auto enabled() const -> bool;
+    inline auto dropped() const -> std::uint64_t;
+
+    inline void push(StepRecord const& record);
+
+    //! Writes all pending records, stops the writer and closes the file.
+    void close();
+
+private:
+    void writer();
+    void write(StepRecord const& record);
+
+private:
+    bool m_enabled;
+    std::ofstream m_out;
+
+    utils::SpscRing<StepRecord> m_ring;
+    std::atomic<bool> m_shutdown;
+    std::uint64_t m_dropped;
+
+    std::thread m_thread;
+};
+
+
+auto TelemetryLog::enabled() const -> bool {
+    return m_enabled;
+}
+
+auto TelemetryLog::dropped() const -> std::uint64_t {
+    return m_dropped;
+}
+
+void TelemetryLog::push(StepRecord const& record) {
+    if (m_enabled && !m_ring.try_push(record)) {
+        m_dropped += 1;
+    }
+}
+
+}   /* namespace core */
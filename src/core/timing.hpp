@@ -0,0 +1,332 @@
+#pragma once
+
+#include "types.hpp"
+#include "core/perf_counters.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+
+
+namespace core {
+
+//! Phases of a single time step (and frame).
+enum class Phase {
+    Dt,
+    Momentum,
+    Pressure,
+    Velocity,
+    Visualization,
+};
+
+const std::size_t NUM_PHASES = 5;
+
+inline auto phase_to_string(Phase phase) -> char const*;
+
+
+//! Timing method of the `PhaseTimer`.
+enum class TimerMode {
+    Disabled,       //!< all calls are no-ops
+    Host,           //!< synchronize the queue at phase boundaries, measure wall-clock time
+    Device,         //!< enqueue profiling markers at phase boundaries, never blocks
+};
+
+
+//! Phase times of a single time step in seconds.
+struct StepTimes {
+    uint_t step;
+    std::array<double, NUM_PHASES> time;
+};
+
+
+//! Timing of the phases of the time step.
+//!
+//! In host mode, timing a phase synchronizes the queue at its start and end,
+//! so that the measured wall-clock time covers the enqueued device work. As
+//! this prevents any overlap between host and device, this mode is only used
+//! on request (e.g. for benchmarks).
+//!
+//! In device mode, markers are enqueued at the phase boundaries instead and
+//! the phase time is the difference of their completion times, i.e. only the
+//! device time is measured. Results become available once the markers have
+//! completed and `collect()` has been called. This mode requires a queue with
+//! `CL_QUEUE_PROFILING_ENABLE`.
+//!
+//! Optionally, hardware performance counters are captured around each phase
+//! in host mode (only meaningful on CPU devices, where the kernels run in the
+//! threads of this process).
+//!
+//! Phases between `begin_step()` and `end_step()` are additionally recorded
+//! per step, the times of a step are available via `pop_step()` once all of
+//! its phases have been measured. Steps are numbered from 1, step 0 denotes
+//! phases outside of any step.
+class PhaseTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Stops the associated phase on destruction.
+    class Scope {
+    public:
+        inline Scope(PhaseTimer* timer);
+        inline Scope(Scope const&) = delete;
+        inline Scope(Scope&& other);
+        inline ~Scope();
+
+    private:
+        PhaseTimer* m_timer;
+    };
+
+    inline PhaseTimer(cl::CommandQueue const& queue, TimerMode mode);
+
+    inline auto enabled() const -> bool;
+    inline auto mode() const -> TimerMode;
+    inline void set_mode(TimerMode mode);
+
+    //! Captures the given counters around each phase in host mode. The
+    //! counters must outlive the timer, or be reset to nullptr.
+    inline void set_counters(PerfCounters const* counters);
+
+    inline void start(Phase phase);
+    inline void stop();
+    inline auto scope(Phase phase) -> Scope;
+
+    //! Records the times of the following phases for the given step (> 0).
+    inline void begin_step(uint_t step);
+    inline void end_step();
+
+    //! Returns the times of the oldest recorded step if all of its phases
+    //! have been measured, false otherwise.
+    inline auto pop_step(StepTimes& times) -> bool;
+
+    //! Accumulates all completed phases measured in device mode. Does not
+    //! block, should be called regularly (e.g. once per frame).
+    inline void collect();
+
+    //! Waits for all pending markers and accumulates them.
+    inline void flush();
+
+    //! Accumulated time of the given phase in seconds.
+    inline auto total(Phase phase) const -> double;
+    inline auto count(Phase phase) const -> uint_t;
+
+    //! Accumulated counter values of the given phase.
+    inline auto counters(Phase phase) const -> PerfSample const&;
+
+private:
+    struct Pending {
+        Phase phase;
+        uint_t step;
+        cl::Event start;
+        cl::Event end;
+    };
+
+    inline void accumulate(Phase phase, uint_t step, double time);
+
+    cl::CommandQueue m_queue;
+    TimerMode m_mode;
+
+    Phase m_phase;
+    Clock::time_point m_start;
+    cl::Event m_start_marker;
+
+    PerfCounters const* m_counters;
+    PerfSample m_counters_start;
+
+    std::deque<Pending> m_pending;
+
+    uint_t m_step;                      // current step, 0 outside of steps
+    std::deque<StepTimes> m_steps;      // recorded steps, oldest first
+
+    std::array<double, NUM_PHASES> m_total;
+    std::array<uint_t, NUM_PHASES> m_count;
+    std::array<PerfSample, NUM_PHASES> m_counter_total;
+};
+
+
+auto phase_to_string(Phase phase) -> char const* {
+    switch (phase) {
+    case Phase::Dt:             return "dt";
+    case Phase::Momentum:       return "momentum";
+    case Phase::Pressure:       return "pressure";
+    case Phase::Velocity:       return "velocity";
+    case Phase::Visualization:  return "visualization";
+    }
+
+    return "unknown";
+}
+
+
+PhaseTimer::Scope::Scope(PhaseTimer* timer)
+    : m_timer{timer} {}
+
+PhaseTimer::Scope::Scope(Scope&& other)
+    : m_timer{other.m_timer}
+{
+    other.m_timer = nullptr;
+}
+
+PhaseTimer::Scope::~Scope() {
+    if (m_timer) {
+        m_timer->stop();
+    }
+}
+
+
+PhaseTimer::PhaseTimer(cl::CommandQueue const& queue, TimerMode mode)
+    : m_queue{queue}
+    , m_mode{mode}
+    , m_phase{Phase::Dt}
+    , m_start{}
+    , m_start_marker{}
+    , m_counters{nullptr}
+    , m_counters_start{}
+    , m_pending{}
+    , m_step{0}
+    , m_steps{}
+    , m_total{}
+    , m_count{}
+    , m_counter_total{} {}
+
+auto PhaseTimer::enabled() const -> bool {
+    return m_mode != TimerMode::Disabled;
+}
+
+auto PhaseTimer::mode() const -> TimerMode {
+    return m_mode;
+}
+
+void PhaseTimer::set_mode(TimerMode mode) {
+    m_mode = mode;
+}
+
+void PhaseTimer::set_counters(PerfCounters const* counters) {
+    m_counters = counters;
+}
+
+void PhaseTimer::start(Phase phase) {
+    m_phase = phase;
+
+    if (m_mode == TimerMode::Host) {
+        m_queue.finish();
+        m_start = Clock::now();
+
+        if (m_counters) {
+            m_counters_start = m_counters->read();
+        }
+
+    } else if (m_mode == TimerMode::Device) {
+        m_queue.enqueueMarkerWithWaitList(nullptr, &m_start_marker);
+    }
+}
+
+void PhaseTimer::stop() {
+    auto const idx = static_cast<std::size_t>(m_phase);
+
+    if (m_mode == TimerMode::Host) {
+        m_queue.finish();
+
+        accumulate(m_phase, m_step, std::chrono::duration<double>(Clock::now() - m_start).count());
+
+        if (m_counters) {
+            m_counter_total[idx] = m_counter_total[idx] + (m_counters->read() - m_counters_start);
+        }
+
+    } else if (m_mode == TimerMode::Device && m_start_marker()) {
+        cl::Event end;
+        m_queue.enqueueMarkerWithWaitList(nullptr, &end);
+
+        m_pending.push_back({m_phase, m_step, std::move(m_start_marker), std::move(end)});
+        m_start_marker = cl::Event{};
+    }
+}
+
+auto PhaseTimer::scope(Phase phase) -> Scope {
+    start(phase);
+    return Scope{this};
+}
+
+void PhaseTimer::begin_step(uint_t step) {
+    m_step = step;
+    m_steps.push_back({step, {}});
+}
+
+void PhaseTimer::end_step() {
+    m_step = 0;
+}
+
+auto PhaseTimer::pop_step(StepTimes& times) -> bool {
+    if (m_steps.empty() || m_steps.front().step == m_step) {
+        return false;
+    }
+
+    auto const step = m_steps.front().step;
+    auto const is_step = [step](Pending const& pending) { return pending.step == step; };
+
+    if (std::any_of(m_pending.begin(), m_pending.end(), is_step)) {
+        return false;
+    }
+
+    times = m_steps.front();
+    m_steps.pop_front();
+    return true;
+}
+
+void PhaseTimer::collect() {
+    // markers complete in order (in-order queue), stop at the first pending one
+    while (!m_pending.empty()) {
+        auto const& pending = m_pending.front();
+        if (pending.end.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
+            break;
+        }
+
+        auto const start = pending.start.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        auto const end = pending.end.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+        accumulate(pending.phase, pending.step, static_cast<double>(end - start) * 1e-9);
+
+        m_pending.pop_front();
+    }
+}
+
+void PhaseTimer::flush() {
+    if (!m_pending.empty()) {
+        m_queue.finish();
+    }
+
+    collect();
+}
+
+void PhaseTimer::accumulate(Phase phase, uint_t step, double time) {
+    auto const idx = static_cast<std::size_t>(phase);
+    m_total[idx] += time;
+    m_count[idx] += 1;
+
+    if (step == 0) {
+        return;
+    }
+
+    // usually the oldest step (device mode) or the newest one (host mode)
+    for (auto& times : m_steps) {
+        if (times.step == step) {
+            times.time[idx] += time;
+            break;
+        }
+    }
+}
+
+auto PhaseTimer::total(Phase phase) const -> double {
+    return m_total[static_cast<std::size_t>(phase)];
+}
+
+auto PhaseTimer::count(Phase phase) const -> uint_t {
+    return m_count[static_cast<std::size_t>(phase)];
+}
+
+auto PhaseTimer::counters(Phase phase) const -> PerfSample const& {
+    return m_counter_total[static_cast<std::size_t>(phase)];
+}
+
+}   /* namespace core */
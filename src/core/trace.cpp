@@ -0,0 +1,143 @@
+#include "core/trace.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace core {
+namespace {
+
+const int TRACE_PID_HOST = 1;
+const int TRACE_PID_DEVICE = 2;
+
+}   /* namespace */
+
+
+Tracer::Tracer(cl::CommandQueue const& queue, char const* file)
+    : m_queue{queue}
+    , m_out{}
+    , m_enabled{file != nullptr}
+    , m_first{true}
+    , m_origin{Clock::now()}
+    , m_device_origin{0}
+    , m_pending{}
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    m_out.open(file, std::ios::trunc);
+    if (!m_out) {
+        std::stringstream msg;
+        msg << "Failed to open trace file `" << file << "`";
+        throw std::runtime_error(msg.str());
+    }
+
+    // calibrate: align device clock to host clock via marker completion
+    cl::Event marker;
+    m_queue.enqueueMarkerWithWaitList(nullptr, &marker);
+    marker.wait();
+
+    m_origin = Clock::now();
+    m_device_origin = marker.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+    m_out << std::fixed << std::setprecision(3);
+    m_out << "{\"traceEvents\": [\n";
+
+    write_metadata(TRACE_PID_HOST, "host");
+    write_metadata(TRACE_PID_DEVICE, "device");
+}
+
+Tracer::~Tracer() {
+    try {
+        close();
+    } catch (...) {
+        // never throw from destructor, the trace is incomplete in this case
+    }
+}
+
+void Tracer::enqueue(cl::CommandQueue const& queue, cl::Kernel const& kernel, cl::NDRange const& global,
+                     cl::NDRange const& local)
+{
+    if (!m_enabled) {
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local);
+        return;
+    }
+
+    auto const start = Clock::now();
+
+    cl::Event event;
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, &event);
+
+    write_host("enqueue", start, Clock::now());
+    m_pending.emplace_back(kernel.getInfo<CL_KERNEL_FUNCTION_NAME>(), event);
+}
+
+void Tracer::collect() {
+    if (!m_enabled) {
+        return;
+    }
+
+    // events complete in order (in-order queue), stop at the first pending one
+    auto it = m_pending.begin();
+    for (; it != m_pending.end(); ++it) {
+        auto const& event = it->second;
+        if (event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
+            break;
+        }
+
+        auto const start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        auto const end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+        double const ts = (static_cast<double>(start) - static_cast<double>(m_device_origin)) * 1e-3;
+        double const dur = static_cast<double>(end - start) * 1e-3;
+
+        write_event(it->first.c_str(), "kernel", TRACE_PID_DEVICE, ts, dur);
+    }
+
+    m_pending.erase(m_pending.begin(), it);
+}
+
+void Tracer::close() {
+    if (!m_enabled) {
+        return;
+    }
+
+    m_queue.finish();
+    collect();
+
+    m_out << "\n]}\n";
+    m_out.close();
+
+    m_enabled = false;
+}
+
+void Tracer::write_host(char const* name, Clock::time_point start, Clock::time_point end) {
+    double const ts = std::chrono::duration<double, std::micro>(start - m_origin).count();
+    double const dur = std::chrono::duration<double, std::micro>(end - start).count();
+
+    write_event(name, "host", TRACE_PID_HOST, ts, dur);
+}
+
+void Tracer::write_event(char const* name, char const* cat, int pid, double ts, double dur) {
+    if (!m_first) {
+        m_out << ",\n";
+    }
+    m_first = false;
+
+    m_out << "{\"name\": \"" << name << "\", \"cat\": \"" << cat << "\", \"ph\": \"X\", "
+          << "\"pid\": " << pid << ", \"tid\": 1, \"ts\": " << ts << ", \"dur\": " << dur << "}";
+}
+
+void Tracer::write_metadata(int pid, char const* name) {
+    if (!m_first) {
+        m_out << ",\n";
+    }
+    m_first = false;
+
+    m_out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid << ", "
+          << "\"args\": {\"name\": \"" << name << "\"}}";
+}
+
+}   /* namespace core */
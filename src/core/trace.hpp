@@ -0,0 +1,118 @@
+#pragma once
+
+#include "types.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace core {
+
+//! Records host-side zones and device-side kernel executions as Chrome trace
+//! events (JSON), which can be viewed in `chrome://tracing` or Perfetto.
+//!
+//! Kernel times are taken from OpenCL profiling events, thus the queue must
+//! have been created with `CL_QUEUE_PROFILING_ENABLE`. Device timestamps are
+//! mapped to the host timeline by a single marker at construction, which
+//! aligns both clocks up to the latency of the marker completion.
+//!
+//! If no output file is given, the tracer is disabled and all calls (except
+//! `enqueue`, which only forwards to the queue) are no-ops.
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Host zone, ends on destruction. The name must outlive the zone.
+    class Zone {
+    public:
+        inline Zone(Tracer* tracer, char const* name);
+        inline Zone(Zone const&) = delete;
+        inline Zone(Zone&& other);
+        inline ~Zone();
+
+        //! Ends the zone before destruction.
+        inline void end();
+
+    private:
+        Tracer* m_tracer;
+        char const* m_name;
+        Clock::time_point m_start;
+    };
+
+    Tracer(cl::CommandQueue const& queue, char const* file);
+    Tracer(Tracer const&) = delete;
+    ~Tracer();
+
+    inline auto enabled() const -> bool;
+
+    inline auto zone(char const* name) -> Zone;
+
+    //! Enqueues the kernel, recording its execution on the device and the
+    //! time spent in the enqueue call on the host.
+    void enqueue(cl::CommandQueue const& queue, cl::Kernel const& kernel, cl::NDRange const& global,
+                 cl::NDRange const& local);
+
+    //! Writes all completed device events. Should be called regularly (e.g.
+    //! once per frame) to limit the number of pending events.
+    void collect();
+
+    //! Waits for all pending events and finishes the trace file.
+    void close();
+
+private:
+    void write_host(char const* name, Clock::time_point start, Clock::time_point end);
+    void write_event(char const* name, char const* cat, int pid, double ts, double dur);
+    void write_metadata(int pid, char const* name);
+
+private:
+    cl::CommandQueue m_queue;
+    std::ofstream m_out;
+    bool m_enabled;
+    bool m_first;
+
+    Clock::time_point m_origin;         // host time of calibration marker
+    cl_ulong m_device_origin;           // device time of calibration marker (ns)
+
+    std::vector<std::pair<std::string, cl::Event>> m_pending;
+};
+
+
+Tracer::Zone::Zone(Tracer* tracer, char const* name)
+    : m_tracer{tracer}
+    , m_name{name}
+    , m_start{tracer ? Clock::now() : Clock::time_point{}} {}
+
+Tracer::Zone::Zone(Zone&& other)
+    : m_tracer{other.m_tracer}
+    , m_name{other.m_name}
+    , m_start{other.m_start}
+{
+    other.m_tracer = nullptr;
+}
+
+Tracer::Zone::~Zone() {
+    end();
+}
+
+void Tracer::Zone::end() {
+    if (m_tracer) {
+        m_tracer->write_host(m_name, m_start, Clock::now());
+        m_tracer = nullptr;
+    }
+}
+
+
+auto Tracer::enabled() const -> bool {
+    return m_enabled;
+}
+
+auto Tracer::zone(char const* name) -> Zone {
+    return Zone{m_enabled ? this : nullptr, name};
+}
+
+}   /* namespace core */
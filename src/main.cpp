@@ -15,29 +15,41 @@
 
 #include "vis/visualizer.hpp"
 
-#include "core/kernel/sources/resources.hpp"
 #include "core/parameters.hpp"
 #include "core/geometry.hpp"
+#include "core/engine.hpp"
+#include "core/simulation.hpp"
+#include "core/field_io.hpp"
+#include "core/timing.hpp"
+#include "core/benchmark.hpp"
+#include "core/trace.hpp"
+#include "core/telemetry.hpp"
+#include "core/metrics.hpp"
+#include "core/perf_counters.hpp"
+#include "core/snapshots.hpp"
 
 #include "utils/pad.hpp"
+#include "utils/parse.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
 #include <numeric>
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <deque>
+#include <sstream>
+#include <limits>
 
 
 const std::string WINDOW_TITLE = "Numerical Simulations Course 2017/18";
 const ivec2 INITIAL_SCREEN_SIZE = {800, 800};
 
-const char* OCL_COMPILER_OPTIONS =
-    "-cl-single-precision-constant "
-    "-cl-denorms-are-zero "
-    "-cl-strict-aliasing "
-    "-cl-fast-relaxed-math "
-    "-Werror";
-
+const double METRICS_INTERVAL = 5.0;     // seconds
+const double PLAYBACK_RATE = 10.0;       // snapshots per second
 
 enum class VisualTarget {
     UVAbsCentered,
@@ -57,6 +69,19 @@ enum class VisualTarget {
 struct Environment {
     char const* params;
     char const* geom;
+    char const* probes;
+    char const* restart;
+    char const* output;
+    char const* bench;
+    char const* trace;
+    char const* log;
+    char const* metrics;
+    char const* snapshots;
+    char const* play;
+    uint_t snapshot_interval;
+    uint_t steps;
+    bool headless;
+    bool perf;
 };
 
 
@@ -67,40 +92,64 @@ int main(int argc, char** argv) try {
     // parse arguments
     Environment env = parse_cmdline(argc, argv);
 
+    if (env.play && env.headless) {
+        std::cout << "Error: Snapshot playback requires a window.\n";
+        return 1;
+    }
+
+    // playback does not solve, outputs of the recorded run must not be overwritten
+    if (env.play && (env.probes || env.output || env.snapshots)) {
+        std::cout << "Error: Snapshot playback cannot be combined with probes, output or snapshot recording.\n";
+        return 1;
+    }
+
     auto params = core::Parameters{};
     if (env.params) params.load(env.params);
-    auto geom = core::Geometry::lid_driven_cavity({128, 128});
-    if (env.geom) geom.load(env.geom);
 
-    auto n_fluid_cells = geom.num_fluid_cells();
+    // statistics and forces are opened (truncated) with the simulation, keep those of the recorded run
+    if (env.play) {
+        params.stats = false;
+        params.forces = false;
+    }
+    auto geometry = core::Geometry::lid_driven_cavity({128, 128});
+    if (env.geom) geometry.load(env.geom);
+
+    // window and visualization, not available in headless mode
+    auto window = std::unique_ptr<sdl::opengl::Window>{};
+    auto visualizer = vis::Visualizer{};
 
-    auto window = sdl::opengl::Window::builder(WINDOW_TITLE, INITIAL_SCREEN_SIZE)
-        .set(SDL_GL_CONTEXT_MAJOR_VERSION, 3)
-        .set(SDL_GL_CONTEXT_MINOR_VERSION, 3)
-        .set(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE)
-        .set(SDL_GL_DOUBLEBUFFER, 1)
-        .set(SDL_WINDOW_RESIZABLE)
-        .build();
+    if (!env.headless) {
+        window = std::make_unique<sdl::opengl::Window>(sdl::opengl::Window::builder(WINDOW_TITLE, INITIAL_SCREEN_SIZE)
+            .set(SDL_GL_CONTEXT_MAJOR_VERSION, 3)
+            .set(SDL_GL_CONTEXT_MINOR_VERSION, 3)
+            .set(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE)
+            .set(SDL_GL_DOUBLEBUFFER, 1)
+            .set(SDL_WINDOW_RESIZABLE)
+            .build());
 
-    opengl::init();
-    sdl::opengl::set_swap_interval(1);
+        opengl::init();
+        sdl::opengl::set_swap_interval(1);
 
-    auto visualizer = vis::Visualizer{};
-    visualizer.initialize(INITIAL_SCREEN_SIZE, geom.size());
+        visualizer.initialize(INITIAL_SCREEN_SIZE, geometry.size());
+    }
 
     // get OpenCL platform
     std::vector<cl::Platform> platforms;
     cl::Platform::get(&platforms);
 
+    // headless mode does not require OpenGL sharing
     cl::Platform platform;
     for (auto const& p : platforms) {
         auto extensions = p.getInfo<CL_PLATFORM_EXTENSIONS>();
-        if (extensions.find(opencl::opengl::EXT_CL_GL_SHARING) != std::string::npos) {
+        if (env.headless || extensions.find(opencl::opengl::EXT_CL_GL_SHARING) != std::string::npos) {
             platform = p;
         }
     }
 
-    if (!platform()) {
+    if (!platform() && env.headless) {
+        std::cout << "Error: No OpenCL platform found.";
+        return 1;
+    } else if (!platform()) {
         std::cout << "Error: No OpenCl platform with support for extension ";
         std::cout << "`" << opencl::opengl::EXT_CL_GL_SHARING << "`";
         std::cout << " found.";
@@ -117,17 +166,20 @@ int main(int argc, char** argv) try {
 
     // get OpenCL device
     std::vector<cl::Device> devices;
-    platform.getDevices(CL_DEVICE_TYPE_GPU, &devices);
+    platform.getDevices(env.headless ? CL_DEVICE_TYPE_ALL : CL_DEVICE_TYPE_GPU, &devices);
 
     cl::Device device;
     for (auto const& d : devices) {
         auto extensions = d.getInfo<CL_DEVICE_EXTENSIONS>();
-        if (extensions.find(opencl::opengl::EXT_CL_GL_SHARING) != std::string::npos) {
+        if (env.headless || extensions.find(opencl::opengl::EXT_CL_GL_SHARING) != std::string::npos) {
             device = d;
         }
     }
 
-    if (!device()) {
+    if (!device() && env.headless) {
+        std::cout << "Error: No OpenCL device found.";
+        return 1;
+    } else if (!device()) {
         std::cout << "Error: No OpenCL device with support for extension ";
         std::cout << "`" << opencl::opengl::EXT_CL_GL_SHARING << "`";
         std::cout << " found.";
@@ -144,9 +196,11 @@ int main(int argc, char** argv) try {
 
     // create OpenCL context
     std::vector<cl_context_properties> properties;
-    for (auto const& prop : opencl::opengl::get_context_share_properties(window)) {
-        properties.push_back(prop.type);
-        properties.push_back(prop.value);
+    if (window) {
+        for (auto const& prop : opencl::opengl::get_context_share_properties(*window)) {
+            properties.push_back(prop.type);
+            properties.push_back(prop.value);
+        }
     }
     properties.push_back(CL_CONTEXT_PLATFORM);
     properties.push_back((cl_context_properties) platform());
@@ -154,186 +208,285 @@ int main(int argc, char** argv) try {
 
     auto cl_context = cl::Context(device, properties.data());
 
-    // program: zero
-    cl::Program::Sources cl_zero_sources;
-    cl_zero_sources.push_back(core::kernel::resources::zero_cl.to_string());
-
-    cl::Program cl_zero_program{cl_context, cl_zero_sources};
-    cl_zero_program.build({device}, OCL_COMPILER_OPTIONS);
-
-    // program: visualize
-    cl::Program::Sources cl_visualize_sources;
-    cl_visualize_sources.push_back(core::kernel::resources::visualize_cl.to_string());
-
-    cl::Program cl_visualize_program{cl_context, cl_visualize_sources};
-    cl_visualize_program.build({device}, OCL_COMPILER_OPTIONS);
-
-    // program: boundaries
-    cl::Program::Sources cl_boundaries_sources;
-    cl_boundaries_sources.push_back(core::kernel::resources::boundaries_cl.to_string());
-
-    cl::Program cl_boundaries_program{cl_context, cl_boundaries_sources};
-    cl_boundaries_program.build({device}, OCL_COMPILER_OPTIONS);
-
-    // program: momentum (preliminary velocities)
-    cl::Program::Sources cl_momentum_sources;
-    cl_momentum_sources.push_back(core::kernel::resources::momentum_cl.to_string());
-
-    cl::Program cl_momentum_program{cl_context, cl_momentum_sources};
-    cl_momentum_program.build({device}, OCL_COMPILER_OPTIONS);
-
-    // program: rhs (right-hand-side of pressure equation)
-    cl::Program::Sources cl_rhs_sources;
-    cl_rhs_sources.push_back(core::kernel::resources::rhs_cl.to_string());
-
-    cl::Program cl_rhs_program{cl_context, cl_rhs_sources};
-    cl_rhs_program.build({device}, OCL_COMPILER_OPTIONS);
-
-    // program: solver
-    cl::Program::Sources cl_solver_sources;
-    cl_solver_sources.push_back(core::kernel::resources::solver_cl.to_string());
+    // engine: command queue and compiled programs
+    // profiling is required for traces and the device timing of the overlay and telemetry log
+    cl_command_queue_properties const queue_properties = (env.trace || env.log || window)
+        ? CL_QUEUE_PROFILING_ENABLE : 0;
+
+    // host and device timeline, all kernels are enqueued via the tracer
+    core::Engine engine{cl_context, device, queue_properties, env.trace};
+
+    auto const& cl_queue = engine.queue();
+    auto const& programs = engine.programs();
+    auto& tracer = engine.tracer();
+
+    // simulation: solver buffers and outputs (statistics, forces)
+    core::Simulation sim{engine, params, std::move(geometry)};
+    auto& geom = sim.geometry();
+
+    // phase timing: synchronous host timing for benchmarks, otherwise non-blocking device timing for the
+    // telemetry log and while the overlay is shown (see below)
+    auto const timer_mode_default = env.bench ? core::TimerMode::Host
+                                  : env.log   ? core::TimerMode::Device
+                                  :             core::TimerMode::Disabled;
+
+    auto& timer = sim.timer();
+    timer.set_mode(timer_mode_default);
+
+    // hardware counters around the phases: only meaningful if the kernels run in this process (CPU devices),
+    // requires synchronous phases and thus benchmark mode
+    auto perf = std::unique_ptr<core::PerfCounters>{};
+    if (env.perf) {
+        if (!env.bench) {
+            std::cout << "Warning: hardware counters require benchmark mode (--bench), ignoring --perf\n";
+        } else if (device.getInfo<CL_DEVICE_TYPE>() != CL_DEVICE_TYPE_CPU) {
+            std::cout << "Warning: hardware counters are only supported on CPU devices, ignoring --perf\n";
+        } else {
+            perf = std::make_unique<core::PerfCounters>();
+
+            if (perf->available()) {
+                timer.set_counters(perf.get());
+            } else {
+                std::cout << "Warning: hardware counters not available (see perf_event_paranoid), ignoring --perf\n";
+                perf.reset();
+            }
+        }
+    }
 
-    cl::Program cl_solver_program{cl_context, cl_solver_sources};
-    cl_solver_program.build({device}, OCL_COMPILER_OPTIONS);
+    // per-step telemetry, written in the background
+    core::TelemetryLog telemetry{env.log};
 
-    // program: velocities (calculate updated velocities)
-    cl::Program::Sources cl_velocities_sources;
-    cl_velocities_sources.push_back(core::kernel::resources::velocities_cl.to_string());
+    // metrics for external monitoring, all output files are accounted for in the bytes written
+    auto metrics = core::MetricsWriter{env.metrics, METRICS_INTERVAL};
+    metrics.set_info(device.getInfo<CL_DEVICE_NAME>(), env.geom ? env.geom : "lid_driven_cavity");
 
-    cl::Program cl_velocities_program{cl_context, cl_velocities_sources};
-    cl_velocities_program.build({device}, OCL_COMPILER_OPTIONS);
+    for (auto const* file : {env.bench, env.trace, env.log, env.output}) {
+        if (file) {
+            metrics.add_output(file);
+        }
+    }
 
-    // program: reduce (calculate updated reduce)
-    cl::Program::Sources cl_reduce_sources;
-    cl_reduce_sources.push_back(core::kernel::resources::reduce_cl.to_string());
+    if (params.stats) {
+        metrics.add_output(params.stats_file);
+    }
 
-    cl::Program cl_reduce_program{cl_context, cl_reduce_sources};
-    cl_reduce_program.build({device}, OCL_COMPILER_OPTIONS);
+    if (params.forces) {
+        metrics.add_output(params.forces_file);
+    }
 
-    // program: copy (calculate updated copy)
-    cl::Program::Sources cl_copy_sources;
-    cl_copy_sources.push_back(core::kernel::resources::copy_cl.to_string());
+    // restart from a stored state, interpolated if stored on a different grid
+    if (env.restart) {
+        auto const state = core::FieldSet::load(env.restart);
 
-    cl::Program cl_copy_program{cl_context, cl_copy_sources};
-    cl_copy_program.build({device}, OCL_COMPILER_OPTIONS);
+        if (state.size.x == geom.size().x && state.size.y == geom.size().y) {
+            sim.restore(state);
+        } else {
+            sim.prolongate(state);
+            std::cout << "Prolongated " << state.size.x << "x" << state.size.y << " state to "
+                      << geom.size().x << "x" << geom.size().y << " grid\n";
+        }
 
+        std::cout << "Restarting at t = " << sim.time() << "\n";
+    }
 
-    cl::CommandQueue cl_queue{cl_context, device};
+    // probes: recorded after each step
+    if (env.probes) {
+        auto set = core::ProbeSet{};
+        set.load(env.probes);
+        metrics.add_output(set.output);
 
-    // set boundary buffer
-    auto buf_boundary = cl::Buffer{cl_context, CL_MEM_READ_ONLY, geom.data().size() * sizeof(cl_uchar)};
-    cl::copy(cl_queue, geom.data().begin(), geom.data().end(), buf_boundary);
+        sim.set_probes(std::move(set));
+    }
 
-    // create component buffers
-    auto buf_u_size = (geom.size().x + 1) * geom.size().y * sizeof(cl_float);
-    auto buf_u = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_u_size};
-    auto buf_f = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_u_size};
+    // snapshot playback: stored states are uploaded into the simulation buffers instead of solving, the
+    // visualization is unchanged
+    struct {
+        std::size_t count;
+        std::size_t loaded;
+        double position;            // current snapshot, fractional while playing
+        double rate;                // snapshots per second
+        bool paused;
+        core::PhaseTimer::Clock::time_point last;
+    } playback = {0, 0, 0.0, PLAYBACK_RATE, false, core::PhaseTimer::Clock::now()};
+
+    if (env.play) {
+        playback.count = core::snapshots::count(env.play);
+        if (playback.count == 0) {
+            std::cout << "Error: No snapshots found at `" << env.play << "`.\n";
+            return 1;
+        }
 
-    auto buf_v_size = geom.size().x * (geom.size().y + 1) * sizeof(cl_float);
-    auto buf_v = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_v_size};
-    auto buf_g = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_v_size};
+        sim.restore(core::FieldSet::load(core::snapshots::file(env.play, 0).c_str()));
+        std::cout << "Playing " << playback.count << " snapshots\n";
+    }
 
-    auto buf_p_size = geom.size().x * geom.size().y * sizeof(cl_float);
-    auto buf_p = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_p_size};
+    auto const seek = [&](double position) {
+        playback.position = std::min(std::max(position, 0.0), static_cast<double>(playback.count - 1));
+    };
 
-    auto buf_rhs_size = (geom.size().x - 2) * (geom.size().y - 2) * sizeof(cl_float);
-    auto buf_rhs = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_rhs_size};
+    // snapshot recording, starting with the initial state, each snapshot is accounted for in the metrics
+    std::size_t n_snapshots = 0;
+    auto const save_snapshot = [&]() {
+        auto const file = core::snapshots::file(env.snapshots, n_snapshots++);
+        sim.state().save(file.c_str());
+        metrics.add_output(file);
+    };
 
-    // buffers for local residual
-    auto buf_res_size = (geom.size().x - 2) * (geom.size().y - 2) * sizeof(cl_float);
-    auto buf_res = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_res_size};
+    if (env.snapshots) {
+        save_snapshot();
+    }
 
-    // buffer vor visualization
-    auto buf_vis_size = geom.size().x * geom.size().y * sizeof(cl_float);
-    auto buf_vis = cl::Buffer{cl_context, CL_MEM_READ_WRITE, buf_vis_size};
+    // buffer for visualization: the scratch buffer of the simulation is free between steps
+    auto const& buf_vis = sim.scratch();
 
     // initialize reduction stuff
-    uint_t const reduce_res_size = (geom.size().x - 2) * (geom.size().y - 2);
     uint_t const reduce_vis_size = geom.size().x * geom.size().y;
-    uint_t const reduce_u_size = (geom.size().x + 1) * geom.size().y;
-    uint_t const reduce_v_size = geom.size().x * (geom.size().y + 1);
     uint_t const reduce_local_size = 128;
 
-    uint_t const reduce_global_size_res = utils::pad_up(reduce_res_size, reduce_local_size);
     uint_t const reduce_global_size_vis = utils::pad_up(reduce_vis_size, reduce_local_size);
-    uint_t const reduce_global_size_u = utils::pad_up(reduce_u_size, reduce_local_size);
-    uint_t const reduce_global_size_v = utils::pad_up(reduce_v_size, reduce_local_size);
-
-    uint_t const reduce_output_size_res = reduce_global_size_res / reduce_local_size;
     uint_t const reduce_output_size_vis = 2 * reduce_global_size_vis / reduce_local_size;
-    uint_t const reduce_output_size_u = reduce_global_size_u / reduce_local_size;
-    uint_t const reduce_output_size_v = reduce_global_size_v / reduce_local_size;
 
-    auto buf_reduce_out_res = cl::Buffer{cl_context, CL_MEM_WRITE_ONLY, reduce_output_size_res * sizeof(cl_float)};
     auto buf_reduce_out_vis = cl::Buffer{cl_context, CL_MEM_WRITE_ONLY, reduce_output_size_vis * sizeof(cl_float)};
-    auto buf_reduce_out_u = cl::Buffer{cl_context, CL_MEM_WRITE_ONLY, reduce_output_size_u * sizeof(cl_float)};
-    auto buf_reduce_out_v = cl::Buffer{cl_context, CL_MEM_WRITE_ONLY, reduce_output_size_v * sizeof(cl_float)};
-
-    auto vec_reduce_out_res = std::vector<cl_float>(reduce_output_size_res);
     auto vec_reduce_out_vis = std::vector<cl_float>(reduce_output_size_vis);
-    auto vec_reduce_out_u = std::vector<cl_float>(reduce_output_size_u);
-    auto vec_reduce_out_v = std::vector<cl_float>(reduce_output_size_v);
 
-    {   // initialize u
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_u);
+    // device memory in use by the simulation and visualization buffers
+    std::size_t const device_memory = sim.device_memory() + buf_reduce_out_vis.getInfo<CL_MEM_SIZE>();
 
-        auto range = cl::NDRange((geom.size().x + 1) * geom.size().y);
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-    }
+    std::cout << "Device memory: " << device_memory / (1024.0 * 1024.0) << " MiB\n\n";
+
+    // create OpenCL reference to OpenGL texture
+    cl::ImageGL cl_image;
+    auto cl_req = std::vector<cl::Memory>{};
 
-    {   // initialize v
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_v);
+    if (window) {
+        glClearColor(0.0, 0.0, 0.0, 1.0);
 
-        auto range = cl::NDRange(geom.size().x * (geom.size().y + 1));
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
+        auto const& texture = visualizer.get_cl_target_texture();
+        cl_image = cl::ImageGL{cl_context, CL_MEM_WRITE_ONLY, texture.target(), 0, texture.handle()};
+        cl_req.push_back(cl_image);
     }
 
-    {   // initialize f
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_f);
+    VisualTarget visual = VisualTarget::UVAbsCentered;
 
-        auto range = cl::NDRange((geom.size().x + 1) * geom.size().y);
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-    }
+    // interactive geometry editing: brush half-width in cells
+    int_t brush = 2;
 
-    {   // initialize g
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_g);
+    auto paint_at = [&](int mouse_x, int mouse_y, core::CellType type) {
+        // generated geometries have no host data, fetch once from the device
+        if (geom.data().empty()) {
+            auto data = std::vector<std::uint8_t>(static_cast<std::size_t>(geom.size().x) * geom.size().y);
+            cl::copy(cl_queue, sim.boundary(), data.begin(), data.end());
+            geom.set_data(std::move(data));
+        }
 
-        auto range = cl::NDRange(geom.size().x * (geom.size().y + 1));
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-    }
+        ivec2 const screen = window->size();
+        ivec2 const cell = {
+            mouse_x * geom.size().x / screen.x,
+            (screen.y - 1 - mouse_y) * geom.size().y / screen.y,
+        };
 
-    {   // initialize p
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_p);
+        geom.paint({{cell.x - brush, cell.y - brush}, {cell.x + brush + 1, cell.y + brush + 1}}, type);
+    };
 
-        auto range = cl::NDRange(geom.size().x * geom.size().y);
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-    }
+    // telemetry records waiting for the device timings of their step
+    auto telemetry_pending = std::deque<core::StepRecord>{};
 
-    {   // initialize rhs
-        cl::Kernel kernel{cl_zero_program, "zero_float"};
-        kernel.setArg(0, buf_rhs);
+    auto const telemetry_emit = [&]() {
+        core::StepTimes times;
 
-        auto range = cl::NDRange((geom.size().x - 2) * (geom.size().y - 2));
-        cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-    }
+        while (timer.pop_step(times)) {
+            auto record = telemetry_pending.front();
+            telemetry_pending.pop_front();
 
+            for (std::size_t i = 0; i < core::NUM_PHASES; i++) {
+                record.phase_time[i] = static_cast<float>(times.time[i] * 1e3);
+            }
 
-    glClearColor(0.0, 0.0, 0.0, 1.0);
+            telemetry.push(record);
+        }
+    };
 
-    // create OpenCL reference to OpenGL texture
-    auto const& texture = visualizer.get_cl_target_texture();
-    auto cl_image = cl::ImageGL{cl_context, CL_MEM_WRITE_ONLY, texture.target(), 0, texture.handle()};
-    auto cl_req = std::vector<cl::Memory>{cl_image};
+    // performance overlay: averages over the last update interval, the phase times are taken from the
+    // timer once the device has completed them and thus may lag behind by a few frames
+    struct {
+        core::PhaseTimer::Clock::time_point start;
+        uint_t frames;
+        uint_t steps;
+        std::array<double, core::NUM_PHASES> total;
+        std::array<uint_t, core::NUM_PHASES> count;
+    } overlay = {core::PhaseTimer::Clock::now(), 0, 0, {}, {}};
+
+    auto update_overlay = [&](uint_t frame_steps) {
+        auto const now = core::PhaseTimer::Clock::now();
+        double const elapsed = std::chrono::duration<double>(now - overlay.start).count();
+
+        overlay.frames += 1;
+        overlay.steps += frame_steps;
+
+        if (elapsed < 0.5) {
+            return;
+        }
 
-    real_t t = 0.0;
-    real_t dt = params.dt;
+        // average time of the phase per step (or per frame for visualization) in ms
+        auto const phase_ms = [&](core::Phase phase, core::Phase per) {
+            auto const i = static_cast<std::size_t>(phase);
+            auto const n = timer.count(per) - overlay.count[static_cast<std::size_t>(per)];
+            return n > 0 ? (timer.total(phase) - overlay.total[i]) / n * 1e3 : 0.0;
+        };
+
+        auto const line = [](char const* label, double value, char const* unit, int precision = 2) {
+            std::stringstream out;
+            out << std::left << std::setw(10) << label << std::right << std::fixed << std::setprecision(precision)
+                << std::setw(10) << value << unit;
+            return out.str();
+        };
+
+        auto const line_sci = [](char const* label, double value) {
+            std::stringstream out;
+            out << std::left << std::setw(10) << label << std::right << std::scientific << std::setprecision(3)
+                << std::setw(10) << value;
+            return out.str();
+        };
+
+        auto const dt_ms = phase_ms(core::Phase::Dt, core::Phase::Dt);
+        auto const momentum_ms = phase_ms(core::Phase::Momentum, core::Phase::Dt);
+        auto const pressure_ms = phase_ms(core::Phase::Pressure, core::Phase::Dt);
+        auto const velocity_ms = phase_ms(core::Phase::Velocity, core::Phase::Dt);
+        auto const vis_ms = phase_ms(core::Phase::Visualization, core::Phase::Visualization);
+
+        auto lines = std::vector<std::string>{
+            line("steps/s", overlay.steps / elapsed, "", 1),
+            line("frame", elapsed / overlay.frames * 1e3, " ms"),
+            line("step", dt_ms + momentum_ms + pressure_ms + velocity_ms, " ms"),
+            line(" dt", dt_ms, " ms"),
+            line(" momentum", momentum_ms, " ms"),
+            line(" pressure", pressure_ms, " ms"),
+            line(" velocity", velocity_ms, " ms"),
+            line("vis", vis_ms, " ms"),
+            line("sor iter", sim.sor_iterations(), "", 0),
+            line_sci("residual", sim.residual()),
+            line_sci("dt", sim.dt()),
+            line("t", sim.time(), "", 4),
+        };
+
+        if (env.play) {
+            lines.push_back(line("snapshot", playback.loaded, "", 0));
+            lines.push_back(line("speed", playback.rate, "/s", 1));
+        }
 
-    VisualTarget visual = VisualTarget::UVAbsCentered;
+        visualizer.set_overlay(lines);
+
+        overlay.start = now;
+        overlay.frames = 0;
+        overlay.steps = 0;
+        for (std::size_t i = 0; i < core::NUM_PHASES; i++) {
+            overlay.total[i] = timer.total(static_cast<core::Phase>(i));
+            overlay.count[i] = timer.count(static_cast<core::Phase>(i));
+        }
+    };
+
+    auto report = core::BenchmarkReport{};
+    auto const loop_start = core::PhaseTimer::Clock::now();
 
     bool running = true;
     bool cont = false;
@@ -341,26 +494,36 @@ int main(int argc, char** argv) try {
         SDL_Event e;
 
         // handle input
-        while (SDL_PollEvent(&e) != 0) {
+        auto zone_events = tracer.zone("poll events");
+        while (window && SDL_PollEvent(&e) != 0) {
             if (e.type == SDL_QUIT) {   // received on SIGINT or when all windows have been closed
                 running = false;
             }
 
-            else if (e.type == SDL_WINDOWEVENT && e.window.windowID == window.id()) {
+            else if (e.type == SDL_WINDOWEVENT && e.window.windowID == window->id()) {
                 if (e.window.event == SDL_WINDOWEVENT_CLOSE) {
-                    window.hide();      // hide on close
+                    window->hide();     // hide on close
                 } else if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
                     glViewport(0, 0, e.window.data1, e.window.data2);
+                    visualizer.resize({e.window.data1, e.window.data2});
                 }
             }
 
-            else if (e.type == SDL_KEYDOWN && e.key.windowID == window.id()) {
+            else if (e.type == SDL_KEYDOWN && e.key.windowID == window->id()) {
                 if (e.key.keysym.sym == SDLK_RETURN) {
                     cont = true;
                 } else if (e.key.keysym.sym == SDLK_l) {
                     visualizer.set_sampler(vis::SamplerType::Linear);
                 } else if (e.key.keysym.sym == SDLK_n) {
                     visualizer.set_sampler(vis::SamplerType::Nearest);
+                } else if (e.key.keysym.sym == SDLK_h) {
+                    bool const enabled = !visualizer.get_overlay_enabled();
+                    visualizer.set_overlay_enabled(enabled);
+
+                    // benchmarks keep their synchronous timing
+                    if (!env.bench) {
+                        timer.set_mode(enabled ? core::TimerMode::Device : timer_mode_default);
+                    }
                 } else if (e.key.keysym.sym == SDLK_ESCAPE) {
                     running = false;
 
@@ -389,349 +552,320 @@ int main(int argc, char** argv) try {
                     visual = VisualTarget::Rhs;
                 } else if (e.key.keysym.sym == SDLK_F6) {
                     visual = VisualTarget::BoundaryTypes;
+
+                } else if (env.play && e.key.keysym.sym == SDLK_SPACE) {
+                    // resuming at the last snapshot starts over
+                    if (playback.paused && playback.position >= playback.count - 1) {
+                        seek(0.0);
+                    }
+                    playback.paused = !playback.paused;
+                } else if (env.play && (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT)) {
+                    double const n = (e.key.keysym.mod & KMOD_SHIFT) ? 10.0 : 1.0;
+                    seek(std::floor(playback.position) + (e.key.keysym.sym == SDLK_LEFT ? -n : n));
+                    playback.paused = true;
+                } else if (env.play && e.key.keysym.sym == SDLK_HOME) {
+                    seek(0.0);
+                } else if (env.play && e.key.keysym.sym == SDLK_END) {
+                    seek(static_cast<double>(playback.count - 1));
+                } else if (env.play && (e.key.keysym.sym == SDLK_PLUS || e.key.keysym.sym == SDLK_EQUALS
+                                        || e.key.keysym.sym == SDLK_KP_PLUS)) {
+                    playback.rate = std::min(playback.rate * 2.0, 1000.0);
+                } else if (env.play && (e.key.keysym.sym == SDLK_MINUS || e.key.keysym.sym == SDLK_KP_MINUS)) {
+                    playback.rate = std::max(playback.rate / 2.0, 0.125);
+
+                } else if (e.key.keysym.sym == SDLK_LEFTBRACKET) {
+                    brush = std::max(brush - 1, 0);
+                } else if (e.key.keysym.sym == SDLK_RIGHTBRACKET) {
+                    brush = brush + 1;
                 }
             }
-        }
 
-        for (int i = 0; i < 100; i++) {
-        // if (cont) { cont = false;
-        {   // set u boundary
-            cl::Kernel kernel_boundary_u{cl_boundaries_program, "set_boundary_u"};
-            kernel_boundary_u.setArg(0, buf_u);
-            kernel_boundary_u.setArg(1, buf_boundary);
-            kernel_boundary_u.setArg(2, static_cast<cl_float>(geom.boundary_velocity().x));
+            else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.windowID == window->id() && !env.play) {
+                if (e.button.button == SDL_BUTTON_LEFT) {
+                    paint_at(e.button.x, e.button.y, core::CellType::NoSlip);
+                } else if (e.button.button == SDL_BUTTON_RIGHT) {
+                    paint_at(e.button.x, e.button.y, core::CellType::Fluid);
+                }
+            }
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_boundary_u, cl::NullRange, range, cl::NullRange);
+            else if (e.type == SDL_MOUSEMOTION && e.motion.windowID == window->id() && !env.play) {
+                if (e.motion.state & SDL_BUTTON_LMASK) {
+                    paint_at(e.motion.x, e.motion.y, core::CellType::NoSlip);
+                } else if (e.motion.state & SDL_BUTTON_RMASK) {
+                    paint_at(e.motion.x, e.motion.y, core::CellType::Fluid);
+                }
+            }
         }
 
-        {   // set v boundary
-            cl::Kernel kernel_boundary_v{cl_boundaries_program, "set_boundary_v"};
-            kernel_boundary_v.setArg(0, buf_v);
-            kernel_boundary_v.setArg(1, buf_boundary);
-            kernel_boundary_v.setArg(2, static_cast<cl_float>(geom.boundary_velocity().y));
+        zone_events.end();
+
+        // upload modified geometry, also done before the next step but required to leave a steady state
+        sim.update_geometry();
+
+        auto const frame_steps_start = sim.steps();
+
+        // playback: advance by the elapsed wall time, stop at the last snapshot
+        if (env.play) {
+            auto const now = core::PhaseTimer::Clock::now();
+            double const elapsed = std::chrono::duration<double>(now - playback.last).count();
+            playback.last = now;
+
+            if (!playback.paused) {
+                seek(playback.position + elapsed * playback.rate);
+                playback.paused = playback.position >= playback.count - 1;
+            }
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_boundary_v, cl::NullRange, range, cl::NullRange);
+            auto const index = static_cast<std::size_t>(playback.position);
+            if (index != playback.loaded) {
+                sim.restore(core::FieldSet::load(core::snapshots::file(env.play, index).c_str()));
+                playback.loaded = index;
+            }
         }
 
-        {   // set pressure boundary    // TODO: only required initially
-            cl::Kernel kernel_boundary_p{cl_boundaries_program, "set_boundary_p"};
-            kernel_boundary_p.setArg(0, buf_p);
-            kernel_boundary_p.setArg(1, buf_boundary);
-            kernel_boundary_p.setArg(2, static_cast<cl_float>(geom.boundary_pressure()));
+        auto const steps_before = sim.steps();
+
+        for (int i = 0; i < 100 && !env.play && !sim.is_steady() && (env.steps == 0 || sim.steps() < env.steps); i++) {
+        // if (cont) { cont = false;
+        auto const step_start = core::PhaseTimer::Clock::now();
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_boundary_p, cl::NullRange, range, cl::NullRange);
+        if (telemetry.enabled()) {
+            timer.begin_step(sim.steps() + 1);
         }
 
-        {   // calculate new dt
+        sim.step();
 
-            // calculate maximum absolutes for u and v
-            cl::Kernel kernel_u{cl_reduce_program, "reduce_max_abs"};
-            kernel_u.setArg(0, buf_u);
-            kernel_u.setArg(1, buf_reduce_out_u);
-            kernel_u.setArg(2, cl::Local(reduce_local_size * sizeof(cl_float)));
-            kernel_u.setArg(3, static_cast<cl_uint>(reduce_u_size));
+        if (env.snapshots && sim.steps() % env.snapshot_interval == 0) {
+            save_snapshot();
+        }
 
-            cl_queue.enqueueNDRangeKernel(kernel_u, cl::NullRange, cl::NDRange(reduce_global_size_u), cl::NDRange(reduce_local_size));
+        if (env.bench) {
+            auto const time = std::chrono::duration<double>(core::PhaseTimer::Clock::now() - step_start).count();
+            report.steps.push_back({sim.time(), sim.dt(), sim.sor_iterations(), sim.residual(), time});
+        }
 
-            cl::Kernel kernel_v{cl_reduce_program, "reduce_max_abs"};
-            kernel_v.setArg(0, buf_v);
-            kernel_v.setArg(1, buf_reduce_out_v);
-            kernel_v.setArg(2, cl::Local(reduce_local_size * sizeof(cl_float)));
-            kernel_v.setArg(3, static_cast<cl_uint>(reduce_v_size));
+        if (telemetry.enabled()) {
+            timer.end_step();
 
-            cl_queue.enqueueNDRangeKernel(kernel_v, cl::NullRange, cl::NDRange(reduce_global_size_v), cl::NDRange(reduce_local_size));
+            // device timings are available once completed, records are written when their step is complete
+            telemetry_pending.push_back({sim.steps(), sim.time(), sim.dt(), sim.sor_iterations(), sim.residual(),
+                                         sim.u_abs_max(), sim.v_abs_max(), {}});
 
-            cl::copy(cl_queue, buf_reduce_out_u, vec_reduce_out_u.begin(), vec_reduce_out_u.end());
-            cl::copy(cl_queue, buf_reduce_out_v, vec_reduce_out_v.begin(), vec_reduce_out_v.end());
+            timer.collect();
+            telemetry_emit();
+        }
+        }
 
-            real_t u_abs_max = static_cast<real_t>(*std::max_element(vec_reduce_out_u.begin(), vec_reduce_out_u.end()));
-            real_t v_abs_max = static_cast<real_t>(*std::max_element(vec_reduce_out_v.begin(), vec_reduce_out_v.end()));
+        if (sim.is_steady() && params.steady_exit) {
+            running = false;
+        }
 
-            rvec2 const d = geom.mesh();
-            real_t const dt_diff = ((d.x*d.x * d.y*d.y) / (d.x*d.x + d.y*d.y)) * params.re * static_cast<real_t>(0.5);
-            real_t const dt_conv = std::min(d.x / u_abs_max, d.y / v_abs_max);
-            dt = std::min(params.dt, params.tau * std::min(dt_diff, dt_conv));
+        // headless: nothing resumes stepping (no geometry edits), stop instead of spinning
+        if (!window && (sim.is_steady() || sim.steps() == steps_before)) {
+            running = false;
         }
 
-        {   // calculate preliminary velocities: f
-            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+        std::cout << "time: " << sim.time() << "\n";
+        std::cout << "dt:   " << sim.dt() << "\n";
+
+        // visualization: skipped in headless mode
+        if (window) {
+            timer.start(core::Phase::Visualization);
+
+            {   // visualize: write visualization data to intermediate buffer
+                cl::Kernel kernel;
+
+                if (visual == VisualTarget::UVAbsCentered) {
+                    kernel = {programs.visualize, "visualize_uv_abs_center"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.u());
+                    kernel.setArg(2, sim.v());
+
+                } else if (visual == VisualTarget::UCentered) {
+                    kernel = {programs.visualize, "visualize_u_center"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.u());
+
+                } else if (visual == VisualTarget::VCentered) {
+                    kernel = {programs.visualize, "visualize_v_center"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.v());
+
+                } else if (visual == VisualTarget::P) {
+                    kernel = {programs.visualize, "visualize_p"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.p());
+
+                } else if (visual == VisualTarget::Vorticity) {
+                    cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+                    kernel = {programs.visualize, "visualize_vorticity"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.u());
+                    kernel.setArg(2, sim.v());
+                    kernel.setArg(3, h);
+
+                } else if (visual == VisualTarget::Stream) {
+                    cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+
+                    kernel = {programs.visualize, "visualize_stream"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.u());
+                    kernel.setArg(2, sim.v());
+                    kernel.setArg(3, h);
+
+                } else if (visual == VisualTarget::U) {
+                    kernel = {programs.visualize, "visualize_u"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.u());
+
+                } else if (visual == VisualTarget::V) {
+                    kernel = {programs.visualize, "visualize_v"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.v());
+
+                } else if (visual == VisualTarget::F) {
+                    kernel = {programs.visualize, "visualize_u"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.f());
+
+                } else if (visual == VisualTarget::G) {
+                    kernel = {programs.visualize, "visualize_v"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.g());
+
+                } else if (visual == VisualTarget::Rhs) {
+                    kernel = {programs.visualize, "visualize_rhs"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.rhs());
+
+                } else if (visual == VisualTarget::BoundaryTypes) {
+                    kernel = {programs.visualize, "visualize_boundaries"};
+                    kernel.setArg(0, buf_vis);
+                    kernel.setArg(1, sim.boundary());
+                }
 
-            cl::Kernel kernel_momentum_f{cl_momentum_program, "momentum_eq_f"};
-            kernel_momentum_f.setArg(0, buf_u);
-            kernel_momentum_f.setArg(1, buf_v);
-            kernel_momentum_f.setArg(2, buf_f);
-            kernel_momentum_f.setArg(3, buf_boundary);
-            kernel_momentum_f.setArg(4, static_cast<cl_float>(params.alpha));
-            kernel_momentum_f.setArg(5, static_cast<cl_float>(params.re));
-            kernel_momentum_f.setArg(6, static_cast<cl_float>(dt));
-            kernel_momentum_f.setArg(7, h);
+                auto range = cl::NDRange(geom.size().x, geom.size().y);
+                tracer.enqueue(cl_queue, kernel, range, cl::NullRange);
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_momentum_f, cl::NullRange, range, cl::NullRange);
-        }
+                // get min/max values
+                cl::Kernel kernel_reduce{programs.reduce, "reduce_minmax"};
+                kernel_reduce.setArg(0, buf_vis);
+                kernel_reduce.setArg(1, buf_reduce_out_vis);
+                kernel_reduce.setArg(2, cl::Local(2 * reduce_local_size * sizeof(cl_float)));
+                kernel_reduce.setArg(3, reduce_vis_size);
 
-        {   // calculate preliminary velocities: g
-            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+                tracer.enqueue(cl_queue, kernel_reduce, cl::NDRange(reduce_global_size_vis), cl::NDRange(reduce_local_size));
 
-            cl::Kernel kernel_momentum_g{cl_momentum_program, "momentum_eq_g"};
-            kernel_momentum_g.setArg(0, buf_u);
-            kernel_momentum_g.setArg(1, buf_v);
-            kernel_momentum_g.setArg(2, buf_g);
-            kernel_momentum_g.setArg(3, buf_boundary);
-            kernel_momentum_g.setArg(4, static_cast<cl_float>(params.alpha));
-            kernel_momentum_g.setArg(5, static_cast<cl_float>(params.re));
-            kernel_momentum_g.setArg(6, static_cast<cl_float>(dt));
-            kernel_momentum_g.setArg(7, h);
+                auto zone = tracer.zone("copy data range");
+                cl::copy(cl_queue, buf_reduce_out_vis, vec_reduce_out_vis.begin(), vec_reduce_out_vis.end());
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_momentum_g, cl::NullRange, range, cl::NullRange);
-        }
+                std::size_t center = vec_reduce_out_vis.size() / 2;
+                cl_float min = *std::min_element(vec_reduce_out_vis.begin(), vec_reduce_out_vis.begin() + center);
+                cl_float max = *std::max_element(vec_reduce_out_vis.begin() + center, vec_reduce_out_vis.end());
 
-        {   // set f boundary
-            cl::Kernel kernel_boundary_u{cl_boundaries_program, "set_boundary_u"};
-            kernel_boundary_u.setArg(0, buf_f);
-            kernel_boundary_u.setArg(1, buf_boundary);
-            kernel_boundary_u.setArg(2, static_cast<cl_float>(geom.boundary_velocity().x));
+                visualizer.set_data_range(min, max);
+            }
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_boundary_u, cl::NullRange, range, cl::NullRange);
-        }
+            // copy visualization data to OpenGL texture via OpenCL
+            {
+                auto zone = tracer.zone("glFinish");
+                glFinish();
+            }
 
-        {   // set g boundary
-            cl::Kernel kernel_boundary_v{cl_boundaries_program, "set_boundary_v"};
-            kernel_boundary_v.setArg(0, buf_g);
-            kernel_boundary_v.setArg(1, buf_boundary);
-            kernel_boundary_v.setArg(2, static_cast<cl_float>(geom.boundary_velocity().y));
-
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel_boundary_v, cl::NullRange, range, cl::NullRange);
-        }
+            cl_queue.enqueueAcquireGLObjects(&cl_req);
 
-        {   // calculate rhs
-            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
+            {
+                cl::Kernel kernel{programs.copy, "copy_buf_to_img"};
+                kernel.setArg(0, cl_image);
+                kernel.setArg(1, buf_vis);
 
-            cl::Kernel kernel_rhs{cl_rhs_program, "compute_rhs"};
-            kernel_rhs.setArg(0, buf_f);
-            kernel_rhs.setArg(1, buf_g);
-            kernel_rhs.setArg(2, buf_rhs);
-            kernel_rhs.setArg(3, buf_boundary);
-            kernel_rhs.setArg(4, static_cast<cl_float>(dt));
-            kernel_rhs.setArg(5, h);
+                auto range = cl::NDRange(geom.size().x, geom.size().y);
+                tracer.enqueue(cl_queue, kernel, range, cl::NullRange);
+            }
 
-            auto range = cl::NDRange(geom.size().x - 2, geom.size().y - 2);
-            cl_queue.enqueueNDRangeKernel(kernel_rhs, cl::NullRange, range, cl::NullRange);
-        }
-
-        {   // run solver
-            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
-
-            cl::Kernel kernel_red{cl_solver_program, "cycle_red"};
-            kernel_red.setArg(0, buf_p);
-            kernel_red.setArg(1, buf_rhs);
-            kernel_red.setArg(2, buf_boundary);
-            kernel_red.setArg(3, h);
-            kernel_red.setArg(4, static_cast<cl_float>(params.omega));
-
-            cl::Kernel kernel_black{cl_solver_program, "cycle_black"};
-            kernel_black.setArg(0, buf_p);
-            kernel_black.setArg(1, buf_rhs);
-            kernel_black.setArg(2, buf_boundary);
-            kernel_black.setArg(3, h);
-            kernel_black.setArg(4, static_cast<cl_float>(params.omega));
-
-            cl::Kernel kernel_boundary_p{cl_boundaries_program, "set_boundary_p"};
-            kernel_boundary_p.setArg(0, buf_p);
-            kernel_boundary_p.setArg(1, buf_boundary);
-            kernel_boundary_p.setArg(2, static_cast<cl_float>(geom.boundary_pressure()));
-
-            cl::Kernel kernel_residual{cl_solver_program, "residual"};
-            kernel_residual.setArg(0, buf_p);
-            kernel_residual.setArg(1, buf_rhs);
-            kernel_residual.setArg(2, buf_boundary);
-            kernel_residual.setArg(3, buf_res);
-            kernel_residual.setArg(4, h);
-
-            cl::Kernel kernel_reduce{cl_reduce_program, "reduce_sum"};
-            kernel_reduce.setArg(0, buf_res);
-            kernel_reduce.setArg(1, buf_reduce_out_res);
-            kernel_reduce.setArg(2, cl::Local(reduce_local_size * sizeof(cl_float)));
-            kernel_reduce.setArg(3, reduce_res_size);
-
-            int_t y_cells_black = (geom.size().y - 2) / 2;
-            auto range_red = cl::NDRange(geom.size().x - 2, geom.size().y - 2 - y_cells_black);
-            auto range_black = cl::NDRange(geom.size().x - 2, y_cells_black);
-            auto range_bounds = cl::NDRange(geom.size().x, geom.size().y);
-            auto range_residual = cl::NDRange(geom.size().x - 2, geom.size().y - 2);
-
-            cl_float residual = std::numeric_limits<cl_float>::infinity();
-            int_t iter = 0;
-            for (; iter < params.itermax && residual > params.eps; iter++) {
-                // solver cycles
-                cl_queue.enqueueNDRangeKernel(kernel_red, cl::NullRange, range_red, cl::NullRange);
-                cl_queue.enqueueNDRangeKernel(kernel_black, cl::NullRange, range_black, cl::NullRange);
-
-                // update boundaries
-                cl_queue.enqueueNDRangeKernel(kernel_boundary_p, cl::NullRange, range_bounds, cl::NullRange);
-
-                {   // calculate residual   // TODO: only do once in k solver-iterations
-                    cl_queue.enqueueNDRangeKernel(kernel_residual, cl::NullRange, range_residual, cl::NullRange);
-
-                    // reduce residual
-                    cl_queue.enqueueNDRangeKernel(kernel_reduce, cl::NullRange, cl::NDRange(reduce_global_size_res), cl::NDRange(reduce_local_size));
-                    cl::copy(cl_queue, buf_reduce_out_res, vec_reduce_out_res.begin(), vec_reduce_out_res.end());
-
-                    residual = std::accumulate(vec_reduce_out_res.begin(), vec_reduce_out_res.end(), static_cast<cl_float>(0.0));
-                    residual = residual / n_fluid_cells;
-                }
+            cl_queue.enqueueReleaseGLObjects(&cl_req);
+            cl_queue.finish();
+
+            if (visualizer.get_overlay_enabled()) {
+                update_overlay(sim.steps() - frame_steps_start);
             }
-        }
 
-        {   // calculate new velocities
-            cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
-
-            cl::Kernel kernel{cl_velocities_program, "new_velocities"};
-            kernel.setArg(0, buf_p);
-            kernel.setArg(1, buf_f);
-            kernel.setArg(2, buf_g);
-            kernel.setArg(3, buf_u);
-            kernel.setArg(4, buf_v);
-            kernel.setArg(5, buf_boundary);
-            kernel.setArg(6, static_cast<cl_float>(dt));
-            kernel.setArg(7, h);
-
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
-        }
-
-        t += dt;
-        }
-        std::cout << "time: " << t << "\n";
-        std::cout << "dt:   " << dt << "\n";
-
-        {   // visualize: write visualization data to intermediate buffer
-            cl::Kernel kernel;
-
-            if (visual == VisualTarget::UVAbsCentered) {
-                kernel = {cl_visualize_program, "visualize_uv_abs_center"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_u);
-                kernel.setArg(2, buf_v);
-
-            } else if (visual == VisualTarget::UCentered) {
-                kernel = {cl_visualize_program, "visualize_u_center"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_u);
-
-            } else if (visual == VisualTarget::VCentered) {
-                kernel = {cl_visualize_program, "visualize_v_center"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_v);
-
-            } else if (visual == VisualTarget::P) {
-                kernel = {cl_visualize_program, "visualize_p"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_p);
-
-            } else if (visual == VisualTarget::Vorticity) {
-                cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
-
-                kernel = {cl_visualize_program, "visualize_vorticity"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_u);
-                kernel.setArg(2, buf_v);
-                kernel.setArg(3, h);
-
-            } else if (visual == VisualTarget::Stream) {
-                cl_float2 h = {{ static_cast<cl_float>(geom.mesh().x), static_cast<cl_float>(geom.mesh().y) }};
-
-                kernel = {cl_visualize_program, "visualize_stream"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_u);
-                kernel.setArg(2, buf_v);
-                kernel.setArg(3, h);
-
-            } else if (visual == VisualTarget::U) {
-                kernel = {cl_visualize_program, "visualize_u"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_u);
-
-            } else if (visual == VisualTarget::V) {
-                kernel = {cl_visualize_program, "visualize_v"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_v);
-
-            } else if (visual == VisualTarget::F) {
-                kernel = {cl_visualize_program, "visualize_u"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_f);
-
-            } else if (visual == VisualTarget::G) {
-                kernel = {cl_visualize_program, "visualize_v"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_g);
-
-            } else if (visual == VisualTarget::Rhs) {
-                kernel = {cl_visualize_program, "visualize_rhs"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_rhs);
-
-            } else if (visual == VisualTarget::BoundaryTypes) {
-                kernel = {cl_visualize_program, "visualize_boundaries"};
-                kernel.setArg(0, buf_vis);
-                kernel.setArg(1, buf_boundary);
+            // render via OpenGL
+            glClear(GL_COLOR_BUFFER_BIT);
+            visualizer.draw();
+
+            {
+                auto zone = tracer.zone("swap_buffers");
+                window->swap_buffers();
             }
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
+            opengl::check_error();
+
+            timer.stop();
+        }
 
-            // get min/max values
-            cl::Kernel kernel_reduce{cl_reduce_program, "reduce_minmax"};
-            kernel_reduce.setArg(0, buf_vis);
-            kernel_reduce.setArg(1, buf_reduce_out_vis);
-            kernel_reduce.setArg(2, cl::Local(2 * reduce_local_size * sizeof(cl_float)));
-            kernel_reduce.setArg(3, reduce_vis_size);
+        report.frames += 1;
+        tracer.collect();
+        timer.collect();
 
-            cl_queue.enqueueNDRangeKernel(kernel_reduce, cl::NullRange, cl::NDRange(reduce_global_size_vis), cl::NDRange(reduce_local_size));
-            cl::copy(cl_queue, buf_reduce_out_vis, vec_reduce_out_vis.begin(), vec_reduce_out_vis.end());
+        if (metrics.due()) {
+            metrics.write({sim.steps(), sim.time(), sim.sor_iterations_total(), sim.residual(), device_memory});
+        }
 
-            std::size_t center = vec_reduce_out_vis.size() / 2;
-            cl_float min = *std::min_element(vec_reduce_out_vis.begin(), vec_reduce_out_vis.begin() + center);
-            cl_float max = *std::max_element(vec_reduce_out_vis.begin() + center, vec_reduce_out_vis.end());
+        // playback shows all snapshots, regardless of the parameters of the recorded run
+        if (!env.play && params.t_end > 0 && sim.time() >= params.t_end) {
+            break;
+        }
 
-            visualizer.set_data_range(min, max);
+        if (!env.play && env.steps > 0 && sim.steps() >= env.steps) {
+            break;
         }
+    }
 
-        // copy visualization data to OpenGL texture via OpenCL
-        glFinish();
-        cl_queue.enqueueAcquireGLObjects(&cl_req);
+    if (telemetry.enabled()) {
+        timer.flush();
+        telemetry_emit();
+    }
 
-        {
-            cl::Kernel kernel{cl_copy_program, "copy_buf_to_img"};
-            kernel.setArg(0, cl_image);
-            kernel.setArg(1, buf_vis);
+    tracer.close();
+    telemetry.close();
 
-            auto range = cl::NDRange(geom.size().x, geom.size().y);
-            cl_queue.enqueueNDRangeKernel(kernel, cl::NullRange, range, cl::NullRange);
+    if (telemetry.dropped() > 0) {
+        std::cout << "telemetry: dropped " << telemetry.dropped() << " records\n";
+    }
+
+    if (env.bench) {
+        report.device = device.getInfo<CL_DEVICE_NAME>();
+        report.scenario = env.geom ? env.geom : "lid_driven_cavity";
+        report.size = geom.size();
+        report.fluid_cells = sim.fluid_cells();
+        report.device_memory = device_memory;
+        report.wall_time = std::chrono::duration<double>(core::PhaseTimer::Clock::now() - loop_start).count();
+
+        report.has_counters = perf != nullptr;
+        for (std::size_t i = 0; i < core::NUM_PHASES; i++) {
+            report.phase_time[i] = timer.total(static_cast<core::Phase>(i));
+            report.phase_counters[i] = timer.counters(static_cast<core::Phase>(i));
         }
 
-        cl_queue.enqueueReleaseGLObjects(&cl_req);
-        cl_queue.finish();
+        report.save(env.bench);
 
-        // render via OpenGL
-        glClear(GL_COLOR_BUFFER_BIT);
-        visualizer.draw();
+        std::cout << "benchmark written: " << env.bench << " (" << report.steps.size() << " steps, "
+                  << report.mlups() << " MLUPS)\n";
+    }
 
-        window.swap_buffers();
-        opengl::check_error();
+    // statistics, probes and forces, none of them are recorded during playback
+    if (!env.play) {
+        sim.finish();
+    }
 
-        if (params.t_end > 0 && t >= params.t_end) {
-            break;
-        }
+    if (env.output) {
+        sim.state().save(env.output);
     }
 
+    // final state, after all outputs have been written
+    metrics.write({sim.steps(), sim.time(), sim.sor_iterations_total(), sim.residual(), device_memory});
+
 
 } catch (cl::BuildError const& err) {
     auto const& log = err.getBuildLog();
@@ -776,12 +910,37 @@ auto parse_cmdline(int argc, char** argv) -> Environment {
             "Options:\n"
             "  -h --help                 Show this help message\n"
             "  -g --geometry <file>      Load geometry file (*.geom)\n"
-            "  -p --parameters <file>    Load simulation parameters (*.param)\n";
+            "  -p --parameters <file>    Load simulation parameters (*.param)\n"
+            "  -r --probes <file>        Record probes defined in file (*.probes)\n"
+            "  -o --output <file>        Write the final state (*.field)\n"
+            "  --restart <file>          Start from a stored state (*.field), interpolated if of a coarser grid\n"
+            "  -s --snapshots <dir>      Write snapshots of the state to the given (existing) directory\n"
+            "  --snapshot-interval <n>   Steps between snapshots (default: 10)\n"
+            "  --play <dir|file>         Play back snapshots or a single state instead of solving (same geometry)\n"
+            "  -n --steps <n>            Stop after the given number of time steps\n"
+            "  -b --bench <file>         Record phase timings and write benchmark report (*.json)\n"
+            "  -t --trace <file>         Write host and device timeline as Chrome trace (*.json)\n"
+            "  -l --log <file>           Write per-step telemetry log (*.csv)\n"
+            "  -m --metrics <file>       Periodically write metrics in Prometheus text format (*.prom)\n"
+            "  --headless                Run without window and visualization\n"
+            "  --perf                    Capture hardware counters per phase (with --bench, CPU devices only)\n";
         std::cout << std::endl;
         std::exit(status);
     };
 
-    Environment env{nullptr, nullptr};
+    // positive integer, the whole value has to be a valid number
+    auto positive = [&](char const* value, char const* name) -> uint_t {
+        long long result = 0;
+        if (!utils::parse_int(value, 1, std::numeric_limits<uint_t>::max(), result)) {
+            std::stringstream msg;
+            msg << "Error: Invalid value '" << value << "' for '" << name << "', expected a positive integer.";
+            print_usage_and_exit(1, msg.str());
+        }
+        return static_cast<uint_t>(result);
+    };
+
+    Environment env{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                    10, 0, false, false};
     for (int i = 1; i < argc; i++) {
         char* arg = argv[i];
 
@@ -813,6 +972,118 @@ auto parse_cmdline(int argc, char** argv) -> Environment {
             }
         }
 
+        else if (  std::strcmp("-r", arg) == 0
+                || std::strcmp("--probes", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.probes = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--probes'.");
+            }
+        }
+
+        else if (  std::strcmp("-o", arg) == 0
+                || std::strcmp("--output", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.output = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--output'.");
+            }
+        }
+
+        else if (  std::strcmp("-s", arg) == 0
+                || std::strcmp("--snapshots", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.snapshots = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--snapshots'.");
+            }
+        }
+
+        else if (std::strcmp("--snapshot-interval", arg) == 0) {
+            if (++i < argc) {
+                env.snapshot_interval = positive(argv[i], "--snapshot-interval");
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--snapshot-interval'.");
+            }
+        }
+
+        else if (std::strcmp("--play", arg) == 0) {
+            if (++i < argc) {
+                env.play = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--play'.");
+            }
+        }
+
+        else if (std::strcmp("--restart", arg) == 0) {
+            if (++i < argc) {
+                env.restart = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--restart'.");
+            }
+        }
+
+        else if (  std::strcmp("-n", arg) == 0
+                || std::strcmp("--steps", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.steps = positive(argv[i], "--steps");
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--steps'.");
+            }
+        }
+
+        else if (  std::strcmp("-b", arg) == 0
+                || std::strcmp("--bench", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.bench = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--bench'.");
+            }
+        }
+
+        else if (  std::strcmp("-t", arg) == 0
+                || std::strcmp("--trace", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.trace = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--trace'.");
+            }
+        }
+
+        else if (  std::strcmp("-l", arg) == 0
+                || std::strcmp("--log", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.log = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--log'.");
+            }
+        }
+
+        else if (  std::strcmp("-m", arg) == 0
+                || std::strcmp("--metrics", arg) == 0
+        ) {
+            if (++i < argc) {
+                env.metrics = argv[i];
+            } else {
+                print_usage_and_exit(1, "Error: Missing argument for '--metrics'.");
+            }
+        }
+
+        else if (std::strcmp("--headless", arg) == 0) {
+            env.headless = true;
+        }
+
+        else if (std::strcmp("--perf", arg) == 0) {
+            env.perf = true;
+        }
+
         else {
             std::stringstream msg;
             msg << "Error: Unknown argument '" << arg << "'.";
@@ -93,6 +93,7 @@ public:
     inline auto get_uniform_location(GLchar const* name, bool required = true) -> GLint;
     inline void set_uniform(GLint loc, GLint val);
     inline void set_uniform(GLint loc, GLfloat val);
+    inline void set_uniform(GLint loc, GLfloat x, GLfloat y);
 
 private:
     GLuint m_handle;
@@ -323,4 +324,8 @@ void Program::set_uniform(GLint loc, GLfloat val) {
     glUniform1f(loc, val);
 }
 
+void Program::set_uniform(GLint loc, GLfloat x, GLfloat y) {
+    glUniform2f(loc, x, y);
+}
+
 }    /* namespace opengl */
@@ -58,6 +58,7 @@ public:
     inline auto operator* () const -> SDL_Window*;
 
     inline auto id() const -> std::uint32_t;
+    inline auto size() const -> ivec2;
 
     inline auto context() const -> Context const&;
 
@@ -169,6 +170,12 @@ auto Window::id() const -> std::uint32_t {
     return m_window_id;
 }
 
+auto Window::size() const -> ivec2 {
+    ivec2 size;
+    SDL_GetWindowSize(m_handle, &size.x, &size.y);
+    return size;
+}
+
 auto Window::context() const -> Context const& {
     return m_context;
 }
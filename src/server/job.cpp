@@ -0,0 +1,60 @@
+#include "server/job.hpp"
+#include "utils/trim.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+
+namespace server {
+
+void Job::parse(std::istream& in) {
+    while (in) {
+        std::string line;
+        if (!std::getline(in, line)) { break; }
+
+        line = line.substr(0, line.find('#'));
+
+        std::stringstream tokenstr{line};
+        std::string key;
+        if (!std::getline(tokenstr, key, '=')) { continue; };
+        key = utils::trim(key);
+
+        if (key.empty()) {
+            continue;
+
+        } else if (key == "params") {
+            tokenstr >> params;
+
+        } else if (key == "geom") {
+            tokenstr >> geom;
+
+        } else if (key == "probes") {
+            tokenstr >> probes;
+
+        } else if (key == "restart") {
+            tokenstr >> restart;
+
+        } else if (key == "output") {
+            tokenstr >> output;
+
+        } else if (key == "steps") {
+            tokenstr >> steps;
+
+        } else if (key == "priority") {
+            tokenstr >> priority;
+
+        } else {
+            std::stringstream msg;
+            msg << "Unknown job key `" << key << "`";
+            throw std::invalid_argument(msg.str());
+        }
+
+        if (tokenstr.fail()) {
+            std::stringstream msg;
+            msg << "Invalid value for job key `" << key << "`";
+            throw std::invalid_argument(msg.str());
+        }
+    }
+}
+
+}   /* namespace server */
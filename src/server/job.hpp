@@ -0,0 +1,138 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+
+namespace server {
+
+//! Simulation job, submitted as `key = value` lines:
+//!
+//!   params   = /path/run.param       # parameter file (optional)
+//!   geom     = /path/run.geom        # geometry file (optional)
+//!   probes   = /path/run.probes      # probe file (optional)
+//!   restart  = /path/coarse.field    # initial state, interpolated if of a coarser grid (optional)
+//!   output   = /path/result.field    # final u, v, p (optional)
+//!   steps    = 1000                  # maximum number of steps (0: no limit, requires t_end)
+//!   priority = 10                    # higher priorities run first
+//!
+//! Relative paths are resolved against the working directory of the server.
+struct Job {
+    std::uint64_t id       = 0;
+    int_t         priority = 0;
+    uint_t        steps    = 0;
+
+    std::string params;
+    std::string geom;
+    std::string probes;
+    std::string restart;
+    std::string output;
+
+    int client = -1;            // connection the result is reported to
+
+    //! Parse job description.
+    void parse(std::istream& in);
+};
+
+
+//! Thread-safe queue of pending jobs, ordered by priority (and submission
+//! for equal priorities).
+class JobQueue {
+public:
+    inline JobQueue();
+
+    //! Adds a job, returns false if the queue has been closed.
+    inline auto push(Job job) -> bool;
+
+    //! Waits for the next job, returns false if the queue has been closed.
+    inline auto pop(Job& job) -> bool;
+
+    //! Wakes up all waiting workers, returns the jobs still pending.
+    inline auto close() -> std::vector<Job>;
+
+    inline auto size() const -> std::size_t;
+
+private:
+    struct Order {
+        inline auto operator() (Job const& a, Job const& b) const -> bool;
+    };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::priority_queue<Job, std::vector<Job>, Order> m_jobs;
+    bool m_closed;
+};
+
+
+JobQueue::JobQueue()
+    : m_mutex{}
+    , m_cond{}
+    , m_jobs{}
+    , m_closed{false} {}
+
+auto JobQueue::push(Job job) -> bool {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_closed) {
+            return false;
+        }
+
+        m_jobs.push(std::move(job));
+    }
+
+    m_cond.notify_one();
+    return true;
+}
+
+auto JobQueue::pop(Job& job) -> bool {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_cond.wait(lock, [&]() { return m_closed || !m_jobs.empty(); });
+
+    if (m_closed) {
+        return false;
+    }
+
+    job = m_jobs.top();
+    m_jobs.pop();
+    return true;
+}
+
+auto JobQueue::close() -> std::vector<Job> {
+    std::vector<Job> pending;
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_closed = true;
+
+        while (!m_jobs.empty()) {
+            pending.push_back(m_jobs.top());
+            m_jobs.pop();
+        }
+    }
+
+    m_cond.notify_all();
+    return pending;
+}
+
+auto JobQueue::size() const -> std::size_t {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_jobs.size();
+}
+
+auto JobQueue::Order::operator() (Job const& a, Job const& b) const -> bool {
+    // std::priority_queue pops the largest element first
+    if (a.priority != b.priority) {
+        return a.priority < b.priority;
+    }
+
+    return a.id > b.id;
+}
+
+}   /* namespace server */
@@ -0,0 +1,626 @@
+//! Local job server.
+//!
+//! Listens on a Unix domain socket for job descriptions (see `server::Job`)
+//! and runs them on all selected OpenCL devices. Each device is served by a
+//! worker thread with its own engine (context, queue, compiled programs and
+//! buffer pool), which is created once at startup and reused for all jobs,
+//! thus short jobs do not pay for context creation, program builds and buffer
+//! allocation. Pending jobs are scheduled by priority.
+//!
+//! Protocol: the client sends the job description, terminated by an empty
+//! line or by closing its write end. The server answers with
+//!
+//!   queued <id>
+//!
+//! and, once the job has completed, with one of
+//!
+//!   done <id> steps=<n> t=<t> residual=<r> steady=<0|1> wall=<s> cache=<off|miss|hit|resume>
+//!   error <id> <message>
+//!
+//! after which the connection is closed. Clients may disconnect early if they
+//! are not interested in the result.
+//!
+//! With a result cache (`--cache`), the final state of each job (and every
+//! `--checkpoint` steps) is stored in the cache. A job running to `t_end`
+//! (without step limit) of a cached configuration returns the stored result
+//! without computation (`cache=hit`, `steps=0`) or resumes from the latest
+//! stored state before `t_end` (`cache=resume`, `steps` counts the remaining
+//! steps). Probes, forces and statistics only cover the computed steps. Jobs
+//! starting from a `restart` state bypass the cache.
+//!
+
+#include "types.hpp"
+
+#include "opencl/opencl.hpp"
+
+#include "core/engine.hpp"
+#include "core/simulation.hpp"
+#include "core/result_cache.hpp"
+
+#include "server/job.hpp"
+
+#include "utils/parse.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//! Maximum size of a job description in bytes.
+const std::size_t MAX_REQUEST_SIZE = 64 * 1024;
+
+//! Timeout for receiving a job description in seconds.
+const int REQUEST_TIMEOUT = 5;
+
+
+//! Connections whose job description is still being received.
+struct Receivers {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t active = 0;
+};
+
+
+struct Environment {
+    char const* socket;
+    cl_device_type devices;
+    char const* cache;
+    uint_t checkpoint;
+};
+
+
+auto parse_cmdline(int argc, char** argv) -> Environment;
+
+auto open_socket(char const* path) -> int;
+auto read_request(int client) -> std::string;
+void reply(int client, std::string const& msg);
+
+void receive_job(int client, std::uint64_t id, server::JobQueue& queue, Receivers& receivers);
+
+void run_worker(core::Engine& engine, server::JobQueue& queue, core::ResultCache* cache, uint_t checkpoint);
+auto run_job(core::Engine& engine, server::Job const& job, core::ResultCache* cache, uint_t checkpoint)
+    -> std::string;
+
+
+volatile std::sig_atomic_t g_stop = 0;
+std::mutex g_log_mutex;
+
+void handle_signal(int) {
+    g_stop = 1;
+}
+
+template<typename... Args>
+void log_message(Args const&... args) {
+    std::lock_guard<std::mutex> lock{g_log_mutex};
+    using expand = int[];
+    (void) expand{0, ((std::cout << args), 0)...};
+    std::cout << std::endl;
+}
+
+//! Stream buffer forwarding complete lines to `log_message()`, prefixed with
+//! the job id, such that output of concurrent jobs does not interleave.
+class JobLog : public std::streambuf {
+public:
+    explicit JobLog(std::uint64_t id) : m_id{id} {}
+    ~JobLog() { flush_line(); }
+
+protected:
+    auto overflow(int_type c) -> int_type override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+
+        if (traits_type::to_char_type(c) == '\n') {
+            flush_line();
+        } else {
+            m_line.push_back(traits_type::to_char_type(c));
+        }
+        return c;
+    }
+
+private:
+    void flush_line() {
+        if (!m_line.empty()) {
+            log_message("job ", m_id, ": ", m_line);
+            m_line.clear();
+        }
+    }
+
+    std::uint64_t m_id;
+    std::string m_line;
+};
+
+
+int main(int argc, char** argv) try {
+    Environment env = parse_cmdline(argc, argv);
+
+    // engines for all selected devices, created once
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+
+    std::vector<std::unique_ptr<core::Engine>> engines;
+    for (auto const& p : platforms) {
+        std::vector<cl::Device> devices;
+        try {
+            p.getDevices(env.devices, &devices);
+        } catch (cl::Error const&) {
+            continue;                           // no device of this type
+        }
+
+        for (auto const& device : devices) {
+            std::cout << "Using device: " << device.getInfo<CL_DEVICE_NAME>() << "\n";
+            engines.push_back(std::make_unique<core::Engine>(cl::Context{device}, device));
+        }
+    }
+
+    if (engines.empty()) {
+        std::cout << "Error: No OpenCL device found.\n";
+        return 1;
+    }
+
+    // result cache shared by all workers
+    std::unique_ptr<core::ResultCache> cache;
+    if (env.cache) {
+        cache = std::make_unique<core::ResultCache>(env.cache);
+    }
+
+    int const fd = open_socket(env.socket);
+
+    // stop on SIGINT and SIGTERM: handled by the main thread only, and only while waiting in ppoll()
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // failed replies to disconnected clients are ignored
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+
+    // blocked outside of ppoll(), thus a signal arriving before the wait is not lost but delivered by it
+    sigset_t wait_signals;
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &wait_signals);
+    sigdelset(&wait_signals, SIGINT);
+    sigdelset(&wait_signals, SIGTERM);
+
+    // workers: one per device, inherit the blocked signals
+    server::JobQueue queue;
+    std::vector<std::thread> workers;
+
+    for (auto& engine : engines) {
+        workers.emplace_back(run_worker, std::ref(*engine), std::ref(queue), cache.get(), env.checkpoint);
+    }
+
+    log_message("Listening on ", env.socket, " (", engines.size(), " devices)");
+
+    // job descriptions are received by a thread per connection, slow clients do not block others
+    Receivers receivers;
+
+    std::uint64_t next_id = 1;
+    while (!g_stop) {
+        pollfd listener;
+        listener.fd = fd;
+        listener.events = POLLIN;
+        listener.revents = 0;
+
+        if (ppoll(&listener, 1, nullptr, &wait_signals) < 0) {
+            if (errno != EINTR) {
+                log_message("Warning: poll failed: ", std::strerror(errno));
+            }
+            continue;
+        }
+
+        if (!(listener.revents & POLLIN)) {
+            continue;
+        }
+
+        int const client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED) {
+                log_message("Warning: accept failed: ", std::strerror(errno));
+            }
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{receivers.mutex};
+            receivers.active += 1;
+        }
+
+        std::thread{receive_job, client, next_id++, std::ref(queue), std::ref(receivers)}.detach();
+    }
+
+    log_message("Shutting down, waiting for running jobs");
+
+    close(fd);
+    unlink(env.socket);
+
+    for (auto& job : queue.close()) {
+        reply(job.client, "error " + std::to_string(job.id) + " server shutting down\n");
+        close(job.client);
+    }
+
+    // bounded by the receive timeout, jobs received after closing the queue are rejected
+    {
+        std::unique_lock<std::mutex> lock{receivers.mutex};
+        receivers.done.wait(lock, [&]() { return receivers.active == 0; });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+} catch (cl::BuildError const& err) {
+    auto const& log = err.getBuildLog();
+    std::cerr << "OpenCL Build Error: " << err.what() << "\n";
+    for (auto const& entry : log) {
+        std::cerr << "-- LOG -------------------------------------------------------------------------\n";
+        std::cout << "-- Device: " << entry.first.getInfo<CL_DEVICE_NAME>() << "\n";
+        std::cout << entry.second << "\n";
+    }
+    std::cerr << "--------------------------------------------------------------------------------\n";
+    throw err;
+
+} catch (cl::Error const& err) {
+    std::cerr << "OpenCL Error:\n";
+    std::cerr << "  What: " << err.what() << "\n";
+    std::cerr << "  Code: " << err.err() << "\n";
+    throw err;
+
+} catch (std::exception const& err) {
+    std::cerr << "Error: " << err.what() << "\n";
+    return 1;
+}
+
+
+auto open_socket(char const* path) -> int {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (std::strlen(path) >= sizeof(addr.sun_path)) {
+        std::stringstream msg;
+        msg << "Socket path `" << path << "` too long";
+        throw std::invalid_argument(msg.str());
+    }
+
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    // non-blocking: accept() is only called once ppoll() reported a connection, which may be gone again
+    int const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+    }
+
+    // remove stale socket of a previous run, but never any other file
+    struct stat info;
+    if (lstat(path, &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            std::stringstream msg;
+            msg << "Socket path `" << path << "` exists and is not a socket";
+            close(fd);
+            throw std::runtime_error(msg.str());
+        }
+
+        unlink(path);
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::stringstream msg;
+        msg << "Failed to listen on `" << path << "`: " << std::strerror(errno);
+        close(fd);
+        throw std::runtime_error(msg.str());
+    }
+
+    return fd;
+}
+
+auto read_request(int client) -> std::string {
+    timeval timeout;
+    timeout.tv_sec = REQUEST_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // read until an empty line or end of stream
+    std::string request;
+    char buffer[4096];
+
+    while (request.find("\n\n") == std::string::npos) {
+        ssize_t const n = recv(client, buffer, sizeof(buffer), 0);
+
+        if (n == 0) {
+            break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            throw std::runtime_error("Failed to receive job description");
+        }
+
+        request.append(buffer, static_cast<std::size_t>(n));
+        if (request.size() > MAX_REQUEST_SIZE) {
+            throw std::runtime_error("Job description too large");
+        }
+    }
+
+    return request;
+}
+
+void reply(int client, std::string const& msg) {
+    send(client, msg.data(), msg.size(), MSG_NOSIGNAL);
+}
+
+void receive_job(int client, std::uint64_t id, server::JobQueue& queue, Receivers& receivers) {
+    auto job = server::Job{};
+    job.id = id;
+    job.client = client;
+
+    try {
+        std::stringstream request{read_request(client)};
+        job.parse(request);
+
+        reply(client, "queued " + std::to_string(id) + "\n");
+        log_message("job ", id, " queued (priority ", job.priority, ", ", queue.size() + 1, " pending)");
+
+        if (!queue.push(std::move(job))) {
+            reply(client, "error " + std::to_string(id) + " server shutting down\n");
+            close(client);
+        }
+
+    } catch (std::exception const& err) {
+        reply(client, "error " + std::to_string(id) + " " + err.what() + "\n");
+        close(client);
+    }
+
+    std::lock_guard<std::mutex> lock{receivers.mutex};
+    receivers.active -= 1;
+    receivers.done.notify_all();
+}
+
+
+void run_worker(core::Engine& engine, server::JobQueue& queue, core::ResultCache* cache, uint_t checkpoint) {
+    auto const device = engine.device().getInfo<CL_DEVICE_NAME>();
+
+    server::Job job;
+    while (queue.pop(job)) {
+        log_message("job ", job.id, " started on ", device);
+
+        std::string result;
+        try {
+            result = run_job(engine, job, cache, checkpoint);
+        } catch (std::exception const& err) {
+            result = "error " + std::to_string(job.id) + " " + err.what();
+        }
+
+        auto const pool = engine.pool().stats();
+        log_message("job ", job.id, ": ", result, " (", device, ", buffers: ",
+                    pool.allocated / (1024.0 * 1024.0), " MiB allocated, ", pool.reused, " reused, ",
+                    pool.evicted, " evicted)");
+
+        reply(job.client, result + "\n");
+        close(job.client);
+    }
+}
+
+auto run_job(core::Engine& engine, server::Job const& job, core::ResultCache* cache, uint_t checkpoint)
+    -> std::string
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    // warnings and status messages are written via the logger, lines of concurrent jobs do not interleave
+    JobLog log_buffer{job.id};
+    std::ostream log{&log_buffer};
+
+    auto params = core::Parameters{};
+    if (!job.params.empty()) params.load(job.params.c_str(), log);
+
+    auto geom = core::Geometry::lid_driven_cavity({128, 128});
+    if (!job.geom.empty()) geom.load(job.geom.c_str());
+
+    // steady-state detection alone may never trigger, running jobs are completed on shutdown
+    if (job.steps == 0 && params.t_end <= 0.0) {
+        throw std::invalid_argument("Job may not terminate: requires steps or t_end");
+    }
+
+    auto const elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // result cache: only runs to a given time can be looked up, states of all runs from the initial state
+    // are stored
+    if (!job.restart.empty()) {
+        cache = nullptr;
+    }
+
+    std::string key;
+    auto const steady_key = core::ResultCache::steady_key(params);
+    auto cached = core::CacheEntry{};
+    bool resume = false;
+
+    if (cache) {
+        key = core::ResultCache::key(params, geom);
+        resume = job.steps == 0 && params.t_end > 0.0 && cache->find(key, params.t_end, steady_key, cached);
+    }
+
+    if (resume && core::ResultCache::is_result(cached, params.t_end, steady_key)) {
+        if (!job.output.empty()) {
+            cache->load(cached).save(job.output.c_str());
+        }
+
+        std::stringstream out;
+        out << "done " << job.id
+            << " steps=0"
+            << " t=" << cached.t
+            << " residual=" << cached.residual
+            << " steady=" << (cached.steady ? 1 : 0)
+            << " wall=" << elapsed()
+            << " cache=hit";
+
+        return out.str();
+    }
+
+    core::Simulation sim{engine, std::move(params), std::move(geom), log};
+
+    if (resume) {
+        sim.restore(cache->load(cached));
+
+    } else if (!job.restart.empty()) {
+        auto const state = core::FieldSet::load(job.restart.c_str());
+        auto const size = sim.geometry().size();
+
+        if (state.size.x == size.x && state.size.y == size.y) {
+            sim.restore(state);
+        } else {
+            sim.prolongate(state);
+        }
+    }
+
+    if (!job.probes.empty()) {
+        auto set = core::ProbeSet{};
+        set.load(job.probes.c_str(), log);
+        sim.set_probes(std::move(set));
+    }
+
+    // failures to cache a state do not fail the job
+    auto store = [&](real_t t_prev) {
+        try {
+            auto const entry = core::CacheEntry{t_prev, 0.0, sim.residual(), sim.is_steady(), steady_key, {}};
+            cache->store(key, entry, sim.state());
+        } catch (std::runtime_error const& err) {
+            log_message("Warning: job ", job.id, ": failed to cache state at t = ", sim.time(), ": ", err.what());
+        }
+    };
+
+    auto const t_end = sim.params().t_end;
+    auto t_prev = sim.time();
+
+    while (!sim.is_steady()
+           && (job.steps == 0 || sim.steps() < job.steps)
+           && (t_end <= 0.0 || sim.time() < t_end)) {
+        t_prev = sim.time();
+        sim.step();
+
+        if (cache && checkpoint > 0 && sim.steps() % checkpoint == 0) {
+            store(t_prev);
+        }
+    }
+
+    sim.finish();
+
+    if (cache && sim.steps() > 0 && (checkpoint == 0 || sim.steps() % checkpoint != 0)) {
+        store(t_prev);
+    }
+
+    if (!job.output.empty()) {
+        sim.state().save(job.output.c_str());
+    }
+
+    std::stringstream out;
+    out << "done " << job.id
+        << " steps=" << sim.steps()
+        << " t=" << sim.time()
+        << " residual=" << sim.residual()
+        << " steady=" << (sim.is_steady() ? 1 : 0)
+        << " wall=" << elapsed()
+        << " cache=" << (!cache ? "off" : resume ? "resume" : "miss");
+
+    return out.str();
+}
+
+
+auto parse_cmdline(int argc, char** argv) -> Environment {
+    auto print_usage_and_exit = [&](int status, std::string msg = "") {
+        if (!msg.empty()) std::cout << msg << "\n\n";
+        std::cout <<
+            "Usage:\n"
+            "  " << argv[0] << " [options]\n"
+            "\n"
+            "Options:\n"
+            "  -h --help                 Show this help message\n"
+            "  -s --socket <path>        Unix domain socket to listen on (default: numsim.sock)\n"
+            "  -d --devices <type>       Device type to run jobs on: gpu, cpu or all (default: all)\n"
+            "  -c --cache <dir>          Cache results in the given (existing) directory\n"
+            "  --checkpoint <n>          Also cache the state every n steps (default: 0, final state only)\n";
+        std::cout << std::endl;
+        std::exit(status);
+    };
+
+    Environment env{"numsim.sock", CL_DEVICE_TYPE_ALL, nullptr, 0};
+    for (int i = 1; i < argc; i++) {
+        char* arg = argv[i];
+
+        auto next = [&](char const* name) -> char* {
+            if (++i >= argc) {
+                std::stringstream msg;
+                msg << "Error: Missing argument for '" << name << "'.";
+                print_usage_and_exit(1, msg.str());
+            }
+            return argv[i];
+        };
+
+        if (std::strcmp("-h", arg) == 0 || std::strcmp("--help", arg) == 0) {
+            print_usage_and_exit(0);
+
+        } else if (std::strcmp("-s", arg) == 0 || std::strcmp("--socket", arg) == 0) {
+            env.socket = next("--socket");
+
+        } else if (std::strcmp("-d", arg) == 0 || std::strcmp("--devices", arg) == 0) {
+            char const* type = next("--devices");
+
+            if (std::strcmp("gpu", type) == 0) {
+                env.devices = CL_DEVICE_TYPE_GPU;
+            } else if (std::strcmp("cpu", type) == 0) {
+                env.devices = CL_DEVICE_TYPE_CPU;
+            } else if (std::strcmp("all", type) == 0) {
+                env.devices = CL_DEVICE_TYPE_ALL;
+            } else {
+                std::stringstream msg;
+                msg << "Error: Invalid device type '" << type << "'.";
+                print_usage_and_exit(1, msg.str());
+            }
+
+        } else if (std::strcmp("-c", arg) == 0 || std::strcmp("--cache", arg) == 0) {
+            env.cache = next("--cache");
+
+        } else if (std::strcmp("--checkpoint", arg) == 0) {
+            char const* value = next("--checkpoint");
+
+            long long checkpoint = 0;
+            if (!utils::parse_int(value, 0, std::numeric_limits<uint_t>::max(), checkpoint)) {
+                std::stringstream msg;
+                msg << "Error: Invalid value '" << value << "' for '--checkpoint'.";
+                print_usage_and_exit(1, msg.str());
+            }
+            env.checkpoint = static_cast<uint_t>(checkpoint);
+
+        } else {
+            std::stringstream msg;
+            msg << "Error: Unknown argument '" << arg << "'.";
+            print_usage_and_exit(1, msg.str());
+        }
+    }
+
+    return env;
+}
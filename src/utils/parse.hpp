@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+
+namespace utils {
+
+//! Parses `value` as integer in `[min, max]`. The whole string has to be a
+//! valid number, returns false otherwise (including values out of range).
+inline auto parse_int(std::string const& value, long long min, long long max, long long& result) -> bool {
+    std::size_t pos = 0;
+
+    try {
+        result = std::stoll(value, &pos);
+    } catch (std::logic_error const&) {
+        return false;
+    }
+
+    return !value.empty() && pos == value.size() && result >= min && result <= max;
+}
+
+}   /* namespace utils */
@@ -0,0 +1,90 @@
+//! Bounded lock-free queue for a single producer and a single consumer.
+//!
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+
+namespace utils {
+
+//! Ring buffer with a fixed capacity (a power of two). `try_push` may only be
+//! called from one thread and `try_pop` from one (other) thread. Neither call
+//! blocks or allocates.
+template <typename T>
+class SpscRing {
+public:
+    inline explicit SpscRing(std::size_t capacity);
+    inline SpscRing(SpscRing const&) = delete;
+    inline SpscRing(SpscRing&&) = delete;
+
+    inline auto operator= (SpscRing const&) -> SpscRing& = delete;
+    inline auto operator= (SpscRing&&) -> SpscRing& = delete;
+
+    inline auto capacity() const -> std::size_t;
+
+    //! Returns false if the buffer is full.
+    inline auto try_push(T const& value) -> bool;
+
+    //! Returns false if the buffer is empty.
+    inline auto try_pop(T& value) -> bool;
+
+private:
+    std::vector<T> m_data;
+    std::size_t m_mask;
+
+    // written by the consumer and producer only, on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+};
+
+
+template <typename T>
+SpscRing<T>::SpscRing(std::size_t capacity)
+    : m_data(capacity)
+    , m_mask{capacity - 1}
+    , m_head{0}
+    , m_tail{0}
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Ring buffer capacity must be a power of two");
+    }
+}
+
+template <typename T>
+auto SpscRing<T>::capacity() const -> std::size_t {
+    return m_data.size();
+}
+
+template <typename T>
+auto SpscRing<T>::try_push(T const& value) -> bool {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    auto const head = m_head.load(std::memory_order_acquire);
+
+    if (tail - head == m_data.size()) {
+        return false;
+    }
+
+    m_data[tail & m_mask] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+auto SpscRing<T>::try_pop(T& value) -> bool {
+    auto const head = m_head.load(std::memory_order_relaxed);
+    auto const tail = m_tail.load(std::memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    value = m_data[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+}   /* namespace utils */
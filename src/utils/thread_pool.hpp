@@ -0,0 +1,148 @@
+//! Simple pool of persistent worker threads for data-parallel host work.
+//!
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace utils {
+
+class ThreadPool {
+public:
+    inline static auto global() -> ThreadPool&;
+
+    inline explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency());
+    inline ThreadPool(ThreadPool const&) = delete;
+    inline ThreadPool(ThreadPool&&) = delete;
+    inline ~ThreadPool();
+
+    inline auto operator= (ThreadPool const&) -> ThreadPool& = delete;
+    inline auto operator= (ThreadPool&&) -> ThreadPool& = delete;
+
+    inline auto size() const -> std::size_t;
+
+    //! Splits `[begin, end)` into contiguous blocks of at least `grain` items
+    //! and calls `fn(block_begin, block_end)` for each block in parallel.
+    //! Blocks until all blocks have been processed.
+    template <typename F>
+    inline void parallel_for(std::ptrdiff_t begin, std::ptrdiff_t end, std::ptrdiff_t grain, F fn);
+
+private:
+    inline void worker();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv_task;
+    bool m_shutdown;
+};
+
+
+auto ThreadPool::global() -> ThreadPool& {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+    : m_shutdown{false}
+{
+    num_threads = std::max<std::size_t>(num_threads, 1);
+
+    for (std::size_t i = 0; i < num_threads; i++) {
+        m_threads.emplace_back([this]() { worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_shutdown = true;
+    }
+    m_cv_task.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+auto ThreadPool::size() const -> std::size_t {
+    return m_threads.size();
+}
+
+template <typename F>
+void ThreadPool::parallel_for(std::ptrdiff_t begin, std::ptrdiff_t end, std::ptrdiff_t grain, F fn) {
+    std::ptrdiff_t const len = end - begin;
+    if (len <= 0) {
+        return;
+    }
+
+    // number of blocks: at most one per thread, each covering at least `grain` items
+    std::ptrdiff_t const max_blocks = static_cast<std::ptrdiff_t>(m_threads.size());
+    std::ptrdiff_t const n_blocks = std::max<std::ptrdiff_t>(1, std::min(max_blocks, len / std::max<std::ptrdiff_t>(grain, 1)));
+
+    if (n_blocks == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::ptrdiff_t pending = n_blocks - 1;
+
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        for (std::ptrdiff_t i = 1; i < n_blocks; i++) {
+            std::ptrdiff_t const b = begin + (len * i) / n_blocks;
+            std::ptrdiff_t const e = begin + (len * (i + 1)) / n_blocks;
+
+            m_tasks.emplace_back([&, b, e]() {
+                fn(b, e);
+
+                std::lock_guard<std::mutex> done_guard{done_mutex};
+                if (--pending == 0) {
+                    done_cv.notify_one();
+                }
+            });
+        }
+    }
+    m_cv_task.notify_all();
+
+    // process first block on the calling thread
+    fn(begin, begin + len / n_blocks);
+
+    std::unique_lock<std::mutex> done_lock{done_mutex};
+    done_cv.wait(done_lock, [&]() { return pending == 0; });
+}
+
+void ThreadPool::worker() {
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_cv_task.wait(lock, [&]() { return m_shutdown || !m_tasks.empty(); });
+
+            if (m_shutdown && m_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+}   /* namespace utils */
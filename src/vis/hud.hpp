@@ -0,0 +1,209 @@
+#pragma once
+
+#include "types.hpp"
+
+#include "opengl/vertex_array.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/sampler.hpp"
+#include "opengl/texture.hpp"
+
+#include "vis/font.hpp"
+#include "vis/shader/resources.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace vis {
+
+//! Text overlay, rendered into the top-left corner of the screen.
+//!
+//! The text is uploaded as a grid of glyph indices, which is then rasterized
+//! in the fragment shader using the embedded bitmap font. Lower-case letters
+//! are displayed as upper-case ones, unsupported characters as '?'.
+class Hud {
+public:
+    inline Hud();
+    inline Hud(Hud const&) = delete;
+    inline Hud(Hud&& other) = default;
+
+    inline auto operator= (Hud const&) -> Hud& = delete;
+    inline auto operator= (Hud&& other) -> Hud& = default;
+
+    inline void initialize(int scale = 2);
+
+    inline void set_text(std::vector<std::string> const& lines);
+    inline void draw(ivec2 screen);
+
+private:
+    opengl::VertexArray m_vao;
+    opengl::Program m_shader;
+    opengl::Texture m_tex_font;
+    opengl::Texture m_tex_text;
+    opengl::Sampler m_sampler;
+
+    GLint m_shader_loc_screen;
+    GLint m_shader_loc_origin;
+    GLint m_shader_loc_size;
+
+    int m_scale;
+    ivec2 m_text_size;
+};
+
+
+Hud::Hud()
+    : m_shader_loc_screen{-1}
+    , m_shader_loc_origin{-1}
+    , m_shader_loc_size{-1}
+    , m_scale{1}
+    , m_text_size{0, 0} {}
+
+void Hud::initialize(int scale) {
+    // create empty vertex-array
+    auto vao = opengl::VertexArray::create();
+
+    // create shader
+    auto shader_vert = opengl::Shader::create(GL_VERTEX_SHADER);
+    shader_vert.set_source(vis::shader::resources::hud_vs);
+    shader_vert.compile("hud.vs");
+
+    auto shader_frag = opengl::Shader::create(GL_FRAGMENT_SHADER);
+    shader_frag.set_source(vis::shader::resources::hud_fs);
+    shader_frag.compile("hud.fs");
+
+    auto shader = opengl::Program::create();
+    shader.attach(shader_vert);
+    shader.attach(shader_frag);
+    shader.link();
+    shader.detach(shader_frag);
+    shader.detach(shader_vert);
+
+    // create font texture: one texel per glyph row
+    std::vector<std::uint8_t> rows(font::NUM_GLYPHS * font::GLYPH_HEIGHT);
+    for (int glyph = 0; glyph < font::NUM_GLYPHS; glyph++) {
+        for (int row = 0; row < font::GLYPH_HEIGHT; row++) {
+            rows[row * font::NUM_GLYPHS + glyph] = font::GLYPHS[glyph][row];
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto tex_font = opengl::Texture::create(GL_TEXTURE_2D);
+    tex_font.bind();
+    tex_font.image_2d(0, GL_R8UI, {font::NUM_GLYPHS, font::GLYPH_HEIGHT}, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                      rows.data());
+    tex_font.unbind();
+
+    auto tex_text = opengl::Texture::create(GL_TEXTURE_2D);
+
+    // integer textures cannot be filtered
+    auto sampler = opengl::Sampler::create();
+    sampler.set(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    sampler.set(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    sampler.set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    sampler.set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // get uniform locations
+    GLint loc_tex_text = shader.get_uniform_location("u_tex_text");
+    GLint loc_tex_font = shader.get_uniform_location("u_tex_font");
+    GLint loc_scale = shader.get_uniform_location("u_scale");
+    GLint loc_screen = shader.get_uniform_location("u_screen");
+    GLint loc_origin = shader.get_uniform_location("u_origin");
+    GLint loc_size = shader.get_uniform_location("u_size");
+
+    // set texture units and scale in shader
+    shader.bind();
+    shader.set_uniform(loc_tex_text, 0);
+    shader.set_uniform(loc_tex_font, 1);
+    shader.set_uniform(loc_scale, static_cast<GLfloat>(scale));
+    shader.unbind();
+
+    // update
+    m_vao = std::move(vao);
+    m_shader = std::move(shader);
+    m_tex_font = std::move(tex_font);
+    m_tex_text = std::move(tex_text);
+    m_sampler = std::move(sampler);
+
+    m_shader_loc_screen = loc_screen;
+    m_shader_loc_origin = loc_origin;
+    m_shader_loc_size = loc_size;
+
+    m_scale = scale;
+    m_text_size = {0, 0};
+}
+
+void Hud::set_text(std::vector<std::string> const& lines) {
+    int cols = 0;
+    for (auto const& line : lines) {
+        cols = std::max(cols, static_cast<int>(line.size()));
+    }
+
+    int const rows = static_cast<int>(lines.size());
+
+    std::vector<std::uint8_t> text(cols * rows, 0);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < static_cast<int>(lines[y].size()); x++) {
+            char c = static_cast<char>(std::toupper(static_cast<unsigned char>(lines[y][x])));
+            if (c < font::FIRST_CHAR || c > font::LAST_CHAR) {
+                c = '?';
+            }
+
+            text[y * cols + x] = static_cast<std::uint8_t>(c - font::FIRST_CHAR);
+        }
+    }
+
+    m_text_size = {cols, rows};
+    if (cols == 0 || rows == 0) {
+        return;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    m_tex_text.bind();
+    m_tex_text.image_2d(0, GL_R8UI, {cols, rows}, GL_RED_INTEGER, GL_UNSIGNED_BYTE, text.data());
+    m_tex_text.unbind();
+}
+
+void Hud::draw(ivec2 screen) {
+    if (m_text_size.x == 0 || m_text_size.y == 0) {
+        return;
+    }
+
+    // must match the cell layout in hud.fs
+    int const padding = 3;
+    auto const width = static_cast<GLfloat>((m_text_size.x * 6 - 1 + 2 * padding) * m_scale);
+    auto const height = static_cast<GLfloat>((m_text_size.y * 9 - 2 + 2 * padding) * m_scale);
+    auto const margin = static_cast<GLfloat>(8 * m_scale);
+
+    m_shader.bind();
+    m_shader.set_uniform(m_shader_loc_screen, static_cast<GLfloat>(screen.x), static_cast<GLfloat>(screen.y));
+    m_shader.set_uniform(m_shader_loc_origin, margin, margin);
+    m_shader.set_uniform(m_shader_loc_size, width, height);
+
+    m_vao.bind();
+    m_tex_text.bind(0);
+    m_sampler.bind(0);
+    m_tex_font.bind(1);
+    m_sampler.bind(1);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisable(GL_BLEND);
+
+    m_sampler.unbind(1);
+    m_tex_font.unbind();
+    m_sampler.unbind(0);
+    glActiveTexture(GL_TEXTURE0);
+    m_tex_text.unbind();
+    m_vao.unbind();
+    m_shader.unbind();
+}
+
+}   /* namespace vis */
@@ -0,0 +1,46 @@
+//! Fragment shader for the text overlay.
+//!
+//! Renders a grid of characters on a semi-transparent background. The text
+//! texture holds one glyph index per character cell, the font texture one
+//! bit-mask per glyph row (see `vis/font.hpp`).
+
+#version 330 core
+
+in  vec2 v_position;
+out vec4 f_color;
+
+uniform usampler2D u_tex_text;
+uniform usampler2D u_tex_font;
+
+uniform float u_scale = 1.0;
+
+const ivec2 GLYPH_SIZE = ivec2(5, 7);
+const ivec2 CELL_SIZE  = ivec2(6, 9);
+const int   PADDING    = 3;
+
+const vec4 COLOR_TEXT       = vec4(1.0, 1.0, 1.0, 1.0);
+const vec4 COLOR_BACKGROUND = vec4(0.0, 0.0, 0.0, 0.6);
+
+
+void main() {
+    ivec2 pixel = ivec2(v_position / u_scale) - ivec2(PADDING);
+    ivec2 cell = pixel / CELL_SIZE;
+    ivec2 offset = pixel - cell * CELL_SIZE;
+
+    f_color = COLOR_BACKGROUND;
+
+    if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(cell, textureSize(u_tex_text, 0)))) {
+        return;
+    }
+
+    if (any(greaterThanEqual(offset, GLYPH_SIZE))) {
+        return;
+    }
+
+    uint glyph = texelFetch(u_tex_text, cell, 0).r;
+    uint row = texelFetch(u_tex_font, ivec2(int(glyph), offset.y), 0).r;
+
+    if (((row >> uint(GLYPH_SIZE.x - 1 - offset.x)) & 1u) != 0u) {
+        f_color = COLOR_TEXT;
+    }
+}
@@ -0,0 +1,22 @@
+//! Vertex shader for the text overlay.
+//!
+//! Emits vertices for a screen-aligned rectangle, given in pixels relative to
+//! the top-left corner of the screen.
+//! Render with `glDrawArrays(GL_TRIANGLE_STRIP, 0, 4)`.
+
+#version 330 core
+
+out vec2 v_position;
+
+uniform vec2 u_screen;
+uniform vec2 u_origin;
+uniform vec2 u_size;
+
+
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1));
+    vec2 pixel = u_origin + corner * u_size;
+
+    v_position = corner * u_size;
+    gl_Position = vec4(2.0 * pixel.x / u_screen.x - 1.0, 1.0 - 2.0 * pixel.y / u_screen.y, 0.0, 1.0);
+}
@@ -10,6 +10,8 @@ namespace resources {
 extern const utils::Resource fullscreen_vs;
 extern const utils::Resource cubehelix_glsl;
 extern const utils::Resource map_fs;
+extern const utils::Resource hud_vs;
+extern const utils::Resource hud_fs;
 
 }   /* namespace resources */
 }   /* namespace shader */
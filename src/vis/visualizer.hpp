@@ -8,8 +8,12 @@
 #include "opengl/sampler.hpp"
 #include "opengl/texture.hpp"
 
+#include "vis/hud.hpp"
 #include "vis/shader/resources.hpp"
 
+#include <string>
+#include <vector>
+
 
 namespace vis {
 
@@ -42,6 +46,11 @@ public:
     inline auto get_data_range_min();
     inline auto get_data_range_max();
 
+    //! Text overlay drawn on top of the field, if enabled.
+    inline void set_overlay(std::vector<std::string> const& lines);
+    inline void set_overlay_enabled(bool enabled);
+    inline auto get_overlay_enabled() const -> bool;
+
 private:
     ivec2 m_screen_size;
     ivec2 m_data_size;
@@ -60,11 +69,15 @@ private:
 
     utils::Cached<real_t> m_shader_u_norm_min;
     utils::Cached<real_t> m_shader_u_norm_max;
+
+    Hud m_hud;
+    bool m_overlay_enabled;
 };
 
 
 Visualizer::Visualizer()
-    : m_sampler_type{SamplerType::Nearest} {}
+    : m_sampler_type{SamplerType::Nearest}
+    , m_overlay_enabled{false} {}
 
 void Visualizer::initialize(ivec2 screen, ivec2 data_size) {
     m_screen_size = screen;
@@ -121,12 +134,17 @@ void Visualizer::initialize(ivec2 screen, ivec2 data_size) {
     shader.set_uniform(loc_tex_data, 0);
     shader.unbind();
 
+    // create overlay
+    auto hud = Hud{};
+    hud.initialize();
+
     // update
     m_vao = std::move(vao);
     m_shader = std::move(shader);
     m_texture = std::move(texture);
     m_sampler_nearest = std::move(sampler_nearest);
     m_sampler_linear = std::move(sampler_linear);
+    m_hud = std::move(hud);
 
     m_shader_loc_tex_data = loc_tex_data;
     m_shader_loc_norm_min = loc_norm_min;
@@ -166,6 +184,10 @@ void Visualizer::draw() {
     m_texture.unbind();
     m_vao.unbind();
     m_shader.unbind();
+
+    if (m_overlay_enabled) {
+        m_hud.draw(m_screen_size);
+    }
 }
 
 void Visualizer::set_sampler(SamplerType sampler) {
@@ -193,4 +215,16 @@ auto Visualizer::get_data_range_max() {
     return m_shader_u_norm_max.get();
 }
 
+void Visualizer::set_overlay(std::vector<std::string> const& lines) {
+    m_hud.set_text(lines);
+}
+
+void Visualizer::set_overlay_enabled(bool enabled) {
+    m_overlay_enabled = enabled;
+}
+
+auto Visualizer::get_overlay_enabled() const -> bool {
+    return m_overlay_enabled;
+}
+
 }   /* namespace vis */